@@ -0,0 +1,622 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "activity.h"
+
+static bool is_unreachable(activity* a, int i)
+{
+    int type = a->type[i];
+    number equl = a->equl[i];
+    if((type == GE) || (type == EQ)) {
+        if(a->act_fixed[i] + a->act_top[i] < equl) {
+            return true;
+        }
+    }
+    if((type == LE) || (type == EQ)) {
+        if(a->act_fixed[i] + a->act_bottom[i] > equl) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Value a free variable is forced to by a restriction, -1 if not forced */
+static int forced(activity* a, int i, number coeff)
+{
+    int type = a->type[i];
+    number equl = a->equl[i];
+    if((type == LE) || (type == EQ)) {
+        number bottom = a->act_fixed[i] + a->act_bottom[i];
+        if((coeff > 0) && (bottom + coeff > equl)) {
+            return 0;
+        }
+        if((coeff < 0) && (bottom - coeff > equl)) {
+            return 1;
+        }
+    }
+    if((type == GE) || (type == EQ)) {
+        number top = a->act_fixed[i] + a->act_top[i];
+        if((coeff > 0) && (top - coeff < equl)) {
+            return 1;
+        }
+        if((coeff < 0) && (top + coeff < equl)) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/* Add (sign 1) or remove (sign -1) a restriction from the counters */
+static void count_rest(activity* a, int i, int sign)
+{
+    if(activity_violated(a, i)) {
+        a->violated += sign;
+    }
+    if(is_unreachable(a, i)) {
+        a->unreachable += sign;
+        if(sign > 0) {
+            a->conflict = i;
+        }
+    }
+}
+
+activity* activity_new(bip_context* c)
+{
+    int n = c->num_vars;
+    int m = c->num_rest;
+
+    /* Allocate structure */
+    activity* a = (activity*) malloc(sizeof(activity));
+    if(a == NULL) {
+        return NULL;
+    }
+    a->num_vars = n;
+    a->num_rest = m;
+
+    /* Column nonzeros, index the dense restrictions if needed */
+    a->rests = c->sparse_rests;
+    a->own_rests = false;
+    if(a->rests == NULL) {
+        if(c->restrictions != NULL) {
+            a->rests = sparse_from_matrix(c->restrictions, n);
+        } else {
+            a->rests = sparse_new(0, n, 0);
+            if(a->rests != NULL) {
+                sparse_index(a->rests);
+            }
+        }
+        a->own_rests = true;
+    }
+
+    /* Try to allocate dynamic memory */
+    a->fixed      = assignment_new(n);
+    a->best       = assignment_new(n);
+    a->perf       = (number*) malloc(n * sizeof(number));
+    a->type       = (int*) malloc((m + 1) * sizeof(int));
+    a->equl       = (number*) malloc((m + 1) * sizeof(number));
+    a->act_fixed  = (number*) malloc((m + 1) * sizeof(number));
+    a->act_best   = (number*) malloc((m + 1) * sizeof(number));
+    a->act_top    = (number*) malloc((m + 1) * sizeof(number));
+    a->act_bottom = (number*) malloc((m + 1) * sizeof(number));
+    a->trail      = (int*) malloc((n + 1) * sizeof(int));
+    a->queue      = (int*) malloc((m + 1) * sizeof(int));
+    a->queued     = (bool*) calloc(m + 1, sizeof(bool));
+    a->pseudo     = (double*) calloc(2 * n + 1, sizeof(double));
+    a->observed   = (int*) calloc(2 * n + 1, sizeof(int));
+    a->stamp      = (long*) malloc((n + 1) * sizeof(long));
+    a->reason     = (int*) malloc((n + 1) * sizeof(int));
+    a->relax      = c->relaxation ? lp_new(c) : NULL;
+    a->learnt     = NULL;
+    a->cache      = NULL;
+    stats_init(&a->stats);
+    if((c->nogoods > 0) && c->propagate && !c->trace) {
+        a->learnt = nogood_new(n, c->nogoods);
+    }
+    if((a->rests == NULL) ||
+       (a->fixed == NULL) || (a->best == NULL) || (a->perf == NULL) ||
+       (a->type == NULL) || (a->equl == NULL) || (a->act_fixed == NULL) ||
+       (a->act_best == NULL) || (a->act_top == NULL) ||
+       (a->act_bottom == NULL) || (a->trail == NULL) ||
+       (a->queue == NULL) || (a->queued == NULL) || (a->pseudo == NULL) ||
+       (a->observed == NULL) || (a->stamp == NULL) || (a->reason == NULL) ||
+       ((c->nogoods > 0) && c->propagate && !c->trace &&
+        (a->learnt == NULL))) {
+        activity_free(a);
+        return NULL;
+    }
+
+    /* Best fit of each variable */
+    int for_pos = c->maximize ? 1 : 0;
+    int for_neg = c->maximize ? 0 : 1;
+
+    a->fixed_perf = 0;
+    a->free_perf = 0;
+    a->trail_size = 0;
+    a->pseudo_total = 0.0;
+    a->observations = 0;
+    a->clock = 0;
+    a->conflict = -1;
+    for(int j = 0; j < n; j++) {
+        number coeff = c->function[j];
+        int best = 0;
+        if(coeff > 0) {
+            best = for_pos;
+        } else if(coeff < 0) {
+            best = for_neg;
+        }
+        assignment_set(a->best, j, best);
+        a->perf[j] = coeff;
+        a->free_perf += coeff * best;
+    }
+
+    /* Activities with all variables free */
+    a->violated = 0;
+    a->unreachable = 0;
+    for(int i = 0; i < m; i++) {
+        a->type[i] = rest_type(c, i);
+        a->equl[i] = rest_equl(c, i);
+        a->act_fixed[i] = 0;
+        a->act_best[i] = 0;
+        a->act_top[i] = 0;
+        a->act_bottom[i] = 0;
+    }
+    sparse* s = a->rests;
+    for(int j = 0; j < n; j++) {
+        for(int k = s->col_start[j]; k < s->col_start[j + 1]; k++) {
+            int i = s->col_row[k];
+            number coeff = s->col_value[k];
+            a->act_best[i] += coeff * assignment_get(a->best, j);
+            if(coeff > 0) {
+                a->act_top[i] += coeff;
+            } else {
+                a->act_bottom[i] += coeff;
+            }
+        }
+    }
+    for(int i = 0; i < m; i++) {
+        count_rest(a, i, 1);
+    }
+
+    return a;
+}
+
+void activity_fix(activity* a, int var, int value)
+{
+    int best = assignment_get(a->best, var);
+    assignment_set(a->fixed, var, value);
+    a->stamp[var] = a->clock++;
+    a->reason[var] = -1;
+    if(a->learnt != NULL) {
+        nogood_set(a->learnt, var, value);
+    }
+
+    /* Performance */
+    a->fixed_perf += a->perf[var] * value;
+    a->free_perf -= a->perf[var] * best;
+
+    sparse* s = a->rests;
+    for(int k = s->col_start[var]; k < s->col_start[var + 1]; k++) {
+        int i = s->col_row[k];
+        number coeff = s->col_value[k];
+
+        count_rest(a, i, -1);
+        a->act_fixed[i] += coeff * value;
+        a->act_best[i] -= coeff * best;
+        if(coeff > 0) {
+            a->act_top[i] -= coeff;
+        } else {
+            a->act_bottom[i] -= coeff;
+        }
+        count_rest(a, i, 1);
+    }
+}
+
+void activity_release(activity* a, int var)
+{
+    int best = assignment_get(a->best, var);
+    int value = assignment_get(a->fixed, var);
+    assignment_unset(a->fixed, var);
+    if(a->learnt != NULL) {
+        nogood_unset(a->learnt, var, value);
+    }
+
+    a->fixed_perf -= a->perf[var] * value;
+    a->free_perf += a->perf[var] * best;
+
+    sparse* s = a->rests;
+    for(int k = s->col_start[var]; k < s->col_start[var + 1]; k++) {
+        int i = s->col_row[k];
+        number coeff = s->col_value[k];
+
+        count_rest(a, i, -1);
+        a->act_fixed[i] -= coeff * value;
+        a->act_best[i] += coeff * best;
+        if(coeff > 0) {
+            a->act_top[i] += coeff;
+        } else {
+            a->act_bottom[i] += coeff;
+        }
+        count_rest(a, i, 1);
+    }
+}
+
+void activity_move(activity* a, assignment* target)
+{
+    assignment* fixed = a->fixed;
+    for(int w = 0; w < fixed->words; w++) {
+        uint64_t diff = (fixed->mask[w] ^ target->mask[w]) |
+                        (fixed->value[w] ^ target->value[w]);
+
+        /* Release first, so the ones fixed to the other value are free */
+        uint64_t release = diff & fixed->mask[w];
+        while(release != 0) {
+            int j = (w * ASSIGNMENT_BITS) + __builtin_ctzll(release);
+            release &= release - 1;
+            activity_release(a, j);
+        }
+
+        uint64_t fix = diff & target->mask[w];
+        while(fix != 0) {
+            int j = (w * ASSIGNMENT_BITS) + __builtin_ctzll(fix);
+            fix &= fix - 1;
+            activity_fix(a, j, assignment_get(target, j));
+        }
+    }
+}
+
+/* Fix a variable forced by restriction i, -1 for a nogood, pushing it to the
+ * trail and queueing its restrictions, this one included as its margins
+ * changed */
+static void push(activity* a, int j, int value, int i, int head, int* size)
+{
+    sparse* s = a->rests;
+    activity_fix(a, j, value);
+    a->reason[j] = i;
+    a->trail[a->trail_size++] = j;
+
+    for(int l = s->col_start[j]; l < s->col_start[j + 1]; l++) {
+        int r = s->col_row[l];
+        if(!a->queued[r]) {
+            a->queue[(head + *size) % a->num_rest] = r;
+            a->queued[r] = true;
+            (*size)++;
+        }
+    }
+}
+
+/* Fix the variables left alone in the nogoods of a fixed variable */
+static void unit(activity* a, int var, int head, int* size)
+{
+    if(a->learnt == NULL) {
+        return;
+    }
+    int lit = (2 * var) + assignment_get(a->fixed, var);
+    while(!activity_refuted(a)) {
+        int left = nogood_unit(a->learnt, lit, a->fixed);
+        if(left == -1) {
+            break;
+        }
+        push(a, left / 2, 1 - (left % 2), -1, head, size);
+    }
+}
+
+bool activity_propagate(activity* a, int var)
+{
+    sparse* s = a->rests;
+    int m = a->num_rest;
+
+    /* Circular queue, a restriction is queued at most once at a time. The
+     * nogoods of the variables pushed to the trail are checked in order. */
+    int head = 0;
+    int size = 0;
+    int checked = a->trail_size;
+    if(var == -1) {
+        for(int i = 0; i < m; i++) {
+            a->queue[size++] = i;
+            a->queued[i] = true;
+        }
+        for(int j = 0; j < a->num_vars; j++) {
+            if(assignment_get(a->fixed, j) != -1) {
+                unit(a, j, head, &size);
+            }
+        }
+    } else {
+        for(int k = s->col_start[var]; k < s->col_start[var + 1]; k++) {
+            int i = s->col_row[k];
+            a->queue[size++] = i;
+            a->queued[i] = true;
+        }
+        unit(a, var, head, &size);
+    }
+
+    while(((size > 0) || (checked < a->trail_size)) &&
+          (a->unreachable == 0) && !activity_refuted(a)) {
+
+        /* Nogoods first, they are cheaper */
+        if(checked < a->trail_size) {
+            unit(a, a->trail[checked++], head, &size);
+            continue;
+        }
+
+        int i = a->queue[head];
+        head = (head + 1) % m;
+        size--;
+        a->queued[i] = false;
+
+        for(int k = s->row_start[i]; k < s->row_start[i + 1]; k++) {
+            int j = s->row_column[k];
+            if(assignment_get(a->fixed, j) != -1) {
+                continue;
+            }
+            int value = forced(a, i, s->row_value[k]);
+            if(value != -1) {
+                push(a, j, value, i, head, &size);
+            }
+        }
+    }
+
+    /* Left after a conflict */
+    for(; size > 0; size--) {
+        a->queued[a->queue[head]] = false;
+        head = (head + 1) % m;
+    }
+    return (a->unreachable == 0) && !activity_refuted(a);
+}
+
+/* How far a literal takes the activity of a restriction towards its upper
+ * or its lower bound, from where that variable free leaves it */
+static number damage(number coeff, int value, bool upper)
+{
+    bool raises = ((coeff > 0) == (value == 1));
+    if(raises != upper) {
+        return 0;
+    }
+    return (coeff < 0) ? -coeff : coeff;
+}
+
+static bool contains(int* lits, int size, int lit)
+{
+    for(int k = 0; k < size; k++) {
+        if(lits[k] == lit) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Add to the nogood the fewest variables of restriction i fixed before
+ * 'limit' that, with 'var' at 'value' (var -1 for none), take the activity
+ * past a bound. The literals already in the nogood are used first. FALSE if
+ * it can't be done within NOGOOD_LENGTH literals, the nogood is left as it
+ * was. */
+static bool explain_side(activity* a, int i, bool upper, int var, int value,
+                         long limit, int* lits, int* size)
+{
+    sparse* s = a->rests;
+    int start = *size;
+
+    /* Margin to the bound with every variable free */
+    number slack = upper ? a->equl[i] : -a->equl[i];
+    number pushed = 0;
+    for(int k = s->row_start[i]; k < s->row_start[i + 1]; k++) {
+        int j = s->row_column[k];
+        number coeff = s->row_value[k];
+        int fixed = assignment_get(a->fixed, j);
+        if(upper && (coeff < 0)) {
+            slack -= coeff;
+        } else if(!upper && (coeff > 0)) {
+            slack += coeff;
+        }
+        if(j == var) {
+            pushed += damage(coeff, value, upper);
+        } else if((fixed != -1) &&
+                  contains(lits, start, (2 * j) + fixed)) {
+            pushed += damage(coeff, fixed, upper);
+        }
+    }
+
+    /* Largest first */
+    while(pushed <= slack) {
+        int best = -1;
+        number most = 0;
+        for(int k = s->row_start[i]; k < s->row_start[i + 1]; k++) {
+            int j = s->row_column[k];
+            int fixed = assignment_get(a->fixed, j);
+            if((j == var) || (fixed == -1) || (a->stamp[j] >= limit)) {
+                continue;
+            }
+            number d = damage(s->row_value[k], fixed, upper);
+            if((d > most) && !contains(lits, *size, (2 * j) + fixed)) {
+                most = d;
+                best = j;
+            }
+        }
+        if((best == -1) || (*size == NOGOOD_LENGTH)) {
+            *size = start;
+            return false;
+        }
+        lits[(*size)++] = (2 * best) + assignment_get(a->fixed, best);
+        pushed += most;
+    }
+    return true;
+}
+
+static bool explain(activity* a, int i, int var, int value, long limit,
+                    int* lits, int* size)
+{
+    int type = a->type[i];
+    if(((type == LE) || (type == EQ)) &&
+       explain_side(a, i, true, var, value, limit, lits, size)) {
+        return true;
+    }
+    if(((type == GE) || (type == EQ)) &&
+       explain_side(a, i, false, var, value, limit, lits, size)) {
+        return true;
+    }
+    return false;
+}
+
+bool activity_learn(activity* a)
+{
+    if((a->learnt == NULL) || (a->unreachable == 0) || activity_refuted(a)) {
+        return false;
+    }
+
+    /* The restriction that became unreachable last, any other if it was
+     * undone since */
+    int i = a->conflict;
+    if((i == -1) || !is_unreachable(a, i)) {
+        for(i = 0; !is_unreachable(a, i); i++);
+    }
+
+    int lits[NOGOOD_LENGTH];
+    bool kept[NOGOOD_LENGTH];
+    int size = 0;
+    if(!explain(a, i, -1, 0, LONG_MAX, lits, &size)) {
+        return false;
+    }
+    for(int k = 0; k < size; k++) {
+        kept[k] = false;
+    }
+
+    /* Replace the variables fixed by propagation, latest first */
+    bool resolved = false;
+    while(true) {
+        int pick = -1;
+        for(int k = 0; k < size; k++) {
+            int j = lits[k] / 2;
+            if(!kept[k] && (a->reason[j] != -1) && ((pick == -1) ||
+               (a->stamp[j] > a->stamp[lits[pick] / 2]))) {
+                pick = k;
+            }
+        }
+        if(pick == -1) {
+            break;
+        }
+
+        int lit = lits[pick];
+        int j = lit / 2;
+        size--;
+        lits[pick] = lits[size];
+        kept[pick] = kept[size];
+
+        int before = size;
+        if(explain(a, a->reason[j], j, 1 - (lit % 2), a->stamp[j],
+                   lits, &size)) {
+            for(int k = before; k < size; k++) {
+                kept[k] = false;
+            }
+            resolved = true;
+        } else {
+            lits[size] = lit;
+            kept[size] = true;
+            size++;
+        }
+    }
+
+    if(!resolved) {
+        return false;
+    }
+    nogood_add(a->learnt, lits, size);
+    return true;
+}
+
+void activity_residual(activity* a, number* rhs)
+{
+    for(int i = 0; i < a->num_rest; i++) {
+        number left = a->equl[i] - a->act_fixed[i];
+        if((a->type[i] == LE) && (left > a->act_top[i])) {
+            left = a->act_top[i];
+        } else if((a->type[i] == GE) && (left < a->act_bottom[i])) {
+            left = a->act_bottom[i];
+        }
+        rhs[i] = left;
+    }
+}
+
+void activity_undo(activity* a, int mark)
+{
+    while(a->trail_size > mark) {
+        activity_release(a, a->trail[--a->trail_size]);
+    }
+}
+
+void activity_best_fit(activity* a, assignment* vars)
+{
+    assignment* fixed = a->fixed;
+    assignment* best = a->best;
+    for(int w = 0; w < fixed->words; w++) {
+        vars->mask[w] = best->mask[w];
+        vars->value[w] = fixed->value[w] | (best->value[w] & ~fixed->mask[w]);
+    }
+}
+
+unsigned int activity_sizeof(activity* a)
+{
+    if(a == NULL) {
+        return 0;
+    }
+    int n = a->num_vars;
+    int m = a->num_rest;
+    int size = sizeof(activity) +
+               assignment_sizeof(a->fixed) + assignment_sizeof(a->best) +
+               (n * sizeof(number)) +
+               (5 * (m + 1) * sizeof(number)) + ((m + 1) * sizeof(int)) +
+               ((n + 1) * sizeof(int)) +
+               ((m + 1) * (sizeof(int) + sizeof(bool))) +
+               ((2 * n + 1) * (sizeof(double) + sizeof(int))) +
+               ((n + 1) * (sizeof(long) + sizeof(int)));
+    if(a->own_rests) {
+        size += sparse_sizeof(a->rests);
+    }
+    size += lp_sizeof(a->relax);
+    size += nogood_sizeof(a->learnt);
+    size += cache_sizeof(a->cache);
+    return size;
+}
+
+void activity_free(activity* a)
+{
+    if(a == NULL) {
+        return;
+    }
+    assignment_free(a->fixed);
+    assignment_free(a->best);
+    free(a->perf);
+    if(a->own_rests) {
+        sparse_free(a->rests);
+    }
+    free(a->type);
+    free(a->equl);
+    free(a->act_fixed);
+    free(a->act_best);
+    free(a->act_top);
+    free(a->act_bottom);
+    free(a->trail);
+    free(a->queue);
+    free(a->queued);
+    free(a->pseudo);
+    free(a->observed);
+    free(a->stamp);
+    free(a->reason);
+    lp_free(a->relax);
+    nogood_free(a->learnt);
+    cache_free(a->cache);
+    stats_clear(&a->stats);
+    free(a);
+}
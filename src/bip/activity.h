@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_ACTIVITY
+#define H_ACTIVITY
+
+#include "bip.h"
+#include "assignment.h"
+#include "lp.h"
+#include "nogood.h"
+#include "cache.h"
+
+/**
+ * Running state of the Implicit Enumeration.
+ *
+ * Keeps the performance of the best fit and, for each restriction, the
+ * activity of the fixed variables plus the contribution of the free ones to
+ * the best fit, to the top and to the bottom margins. Fixing or releasing a
+ * variable updates them walking only the nonzeros of its column, taken from
+ * the column-major index of the restrictions, so a node is evaluated in
+ * constant time:
+ *
+ *     best fit           = fixed_perf + free_perf
+ *     check restrictions = violated == 0
+ *     future factibility = unreachable == 0
+ *
+ * Propagation fixes the free variables whose other value would make a
+ * restriction unreachable, pushing them to a trail that is undone on
+ * backtrack. The LP relaxation is not updated by fixing or releasing
+ * variables, it picks up the fixed variables when solved, see lp_bound().
+ *
+ * When propagation fails the restriction that became unreachable is
+ * explained back to the variables that forced the others, and the result is
+ * kept as a nogood that closes any other node where it holds, see nogood.h.
+ */
+typedef struct {
+
+    int num_vars;
+    int num_rest;
+
+    /* Variables */
+    assignment* fixed;  /* Fixed variables and their values */
+    assignment* best;   /* Best fit value of each variable, all fixed */
+    number* perf;       /* Objective function coefficients */
+
+    /* Restrictions, borrowed from the context if it is sparse */
+    sparse* rests;
+    bool own_rests;
+    int* type;
+    number* equl;
+
+    /* Performance */
+    number fixed_perf;
+    number free_perf;
+
+    /* Activities */
+    number* act_fixed;   /* Fixed variables */
+    number* act_best;    /* Free variables at their best fit */
+    number* act_top;     /* Free variables with positive coefficient */
+    number* act_bottom; /* Free variables with negative coefficient */
+
+    /* Restrictions failing for the best fit and that can't be satisfied */
+    int violated;
+    int unreachable;
+
+    /* Variables fixed by propagation, in order, and restrictions queued */
+    int* trail;
+    int trail_size;
+    int* queue;
+    bool* queued;
+
+    /* Order in which each variable was fixed and the restriction that forced
+     * it, -1 if branched on */
+    long* stamp;
+    int* reason;
+    long clock;
+    int conflict;       /* Restriction that became unreachable last */
+
+    /* Pseudo-costs, the best fit degradation of each branch (2 * var +
+     * value) summed over the times it was observed */
+    double* pseudo;
+    int* observed;
+    double pseudo_total;    /* Of every branch, for the average */
+    int observations;
+
+    /* LP relaxation, NULL if not used or if the model is too big */
+    lp* relax;
+
+    /* Learnt nogoods, NULL if not learning */
+    nogood_db* learnt;
+
+    /* Explored subtrees, NULL if not kept. Only the sequential depth first
+     * search keeps them, it is the one that explores whole subtrees. */
+    trans_cache* cache;
+
+    /* Of the searches run on this state, see stats.h */
+    search_stats stats;
+
+} activity;
+
+/**
+ * Create the running state of the given model with all variables free.
+ *
+ * @param c, the binary integer programming context data structure.
+ * @return a pointer to the activity structure or NULL if enough memory could
+ *         not be allocated.
+ */
+activity* activity_new(bip_context* c);
+
+/**
+ * Check if a restriction fails for the best fit.
+ *
+ * @param a, the activity structure (by reference)
+ * @param i, the index of the restriction.
+ * @return TRUE if the best fit violates the restriction.
+ */
+static inline bool activity_violated(activity* a, int i)
+{
+    number real = a->act_fixed[i] + a->act_best[i];
+    if(a->type[i] == GE) {
+        return real < a->equl[i];
+    }
+    if(a->type[i] == LE) {
+        return real > a->equl[i];
+    }
+    return real != a->equl[i];
+}
+
+/**
+ * Check if a learnt nogood holds.
+ *
+ * @param a, the activity structure (by reference)
+ * @return TRUE if the fixed variables are known not to be factible.
+ */
+static inline bool activity_refuted(activity* a)
+{
+    return (a->learnt != NULL) && (a->learnt->conflicts > 0);
+}
+
+/**
+ * Fix a free variable to a value.
+ *
+ * @param a, the activity structure (by reference)
+ * @param var, the index of the variable.
+ * @param value, 0 or 1.
+ * @return nothing
+ */
+void activity_fix(activity* a, int var, int value);
+
+/**
+ * Release a fixed variable.
+ *
+ * @param a, the activity structure (by reference)
+ * @param var, the index of the variable.
+ * @return nothing
+ */
+void activity_release(activity* a, int var);
+
+/**
+ * Fix and release variables until the fixed ones are the given ones,
+ * touching only the variables that differ.
+ *
+ * @param a, the activity structure (by reference)
+ * @param target, the variables to have fixed and their values.
+ * @return nothing
+ */
+void activity_move(activity* a, assignment* target);
+
+/**
+ * Fix the free variables forced by the restrictions, and by the nogoods
+ * with every other literal holding, until no more are found. Restrictions
+ * are queued when a variable in them is fixed, starting with the ones of the
+ * given variable, and every fixed variable is pushed to the trail.
+ *
+ * @param a, the activity structure (by reference)
+ * @param var, the variable fixed last, -1 to start with every restriction.
+ * @return FALSE if a restriction became unreachable or a nogood holds, in
+ *         which case the propagation stops early.
+ */
+bool activity_propagate(activity* a, int var);
+
+/**
+ * Learn a nogood from the restriction that became unreachable. The fewest
+ * fixed variables that make it unreachable are taken, then each one fixed by
+ * propagation, latest first, is replaced by the fewest fixed before it that
+ * forced it, as long as the nogood fits in NOGOOD_LENGTH literals. Nothing
+ * is learnt if no variable could be replaced, the restriction alone already
+ * says as much.
+ *
+ * @param a, the activity structure (by reference)
+ * @return TRUE if a nogood was added to the database.
+ */
+bool activity_learn(activity* a);
+
+/**
+ * Calculate the residual right hand side of every restriction, its equality
+ * minus the activity of the fixed variables, clamped to the activity of the
+ * free variables that leaves it redundant for any completion.
+ *
+ * @param a, the activity structure (by reference)
+ * @param rhs, the destination vector of num_rest elements.
+ * @return nothing
+ */
+void activity_residual(activity* a, number* rhs);
+
+/**
+ * Release the variables fixed by propagation since the trail had the given
+ * size, in reverse order.
+ *
+ * @param a, the activity structure (by reference)
+ * @param mark, the size of the trail to go back to.
+ * @return nothing
+ */
+void activity_undo(activity* a, int mark);
+
+/**
+ * Copy the best fit assignment (fixed variables plus free variables at their
+ * best fit) to an assignment of num_vars variables, a word at a time.
+ *
+ * @param a, the activity structure (by reference)
+ * @param vars, the destination assignment, left with all variables fixed.
+ * @return nothing
+ */
+void activity_best_fit(activity* a, assignment* vars);
+
+/**
+ * Calculates the memory required by the activity structure.
+ *
+ * @return the size of the structure in bytes.
+ * @param a, the activity structure (by reference)
+ */
+unsigned int activity_sizeof(activity* a);
+
+/**
+ * Free resources associated with an activity structure.
+ *
+ * @return nothing
+ * @param a, the activity structure (by reference)
+ */
+void activity_free(activity* a);
+
+#endif
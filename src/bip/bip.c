@@ -17,7 +17,18 @@
  */
 
 #include "bip.h"
+#include "activity.h"
+#include "branch.h"
+#include "cache.h"
+#include "heuristics.h"
+#include "nogood.h"
+#include "cuts.h"
+#include "symmetry.h"
+#include "parallel.h"
+#include "presolve.h"
+#include "queue.h"
 #include "report.h"
+#include "probe.h"
 
 bip_context* bip_context_new(int num_vars, int num_rest)
 {
@@ -33,6 +44,9 @@ bip_context* bip_context_new(int num_vars, int num_rest)
     }
 
     /* Try to allocate dynamic memory */
+    c->sparse_rests = NULL;
+    c->types = NULL;
+    c->equls = NULL;
     c->restrictions = NULL;
     if(num_rest > 0) {
         c->restrictions = matrix_new(num_rest, num_vars + 2, 0);
@@ -41,16 +55,24 @@ bip_context* bip_context_new(int num_vars, int num_rest)
             return NULL;
         }
     }
-    c->function = (int*) malloc(num_vars * sizeof(int));
+    c->function = (number*) malloc(num_vars * sizeof(number));
     if(c->function == NULL) {
         matrix_free(c->restrictions);
         free(c);
         return NULL;
     }
+    c->candidate = (int*) malloc(num_vars * sizeof(int));
+    if(c->candidate == NULL) {
+        matrix_free(c->restrictions);
+        free(c->function);
+        free(c);
+        return NULL;
+    }
 
     /* Initialize values */
     for(int i = 0; i < num_vars; i++) {
         c->function[i] = 0;
+        c->candidate[i] = -1;
     }
 
     /* Save variables */
@@ -58,198 +80,733 @@ bip_context* bip_context_new(int num_vars, int num_rest)
     c->num_rest = num_rest;
     c->maximize = true;
 
+    /* Options */
+    c->trace = true;
+    c->threads = 1;
+    c->deterministic = false;
+    c->presolve = true;
+    c->propagate = true;
+    c->relaxation = false;
+    c->symmetry = true;
+    c->cuts = true;
+    c->branching = branch_first;
+    c->value_order = false;
+    c->selection = select_depth;
+    c->queue_memory = QUEUE_MEMORY;
+    c->nogoods = NOGOOD_SLOTS;
+    c->cache = false;
+    c->cache_memory = CACHE_MEMORY;
+    c->eviction = evict_oldest;
+    c->heuristics = true;
+    c->heuristics_time = HEURISTICS_TIME;
+    c->node_limit = 0;
+    c->time_limit = 0.0;
+    c->memory_limit = 0;
+    c->progress = NULL;
+    c->progress_data = NULL;
+    c->progress_interval = 0.0;
+    c->cancel = 0;
+
+    /* Result */
+    c->alpha = 0;
+    c->nodes = 0;
+    c->stopped = stop_none;
+    c->bound = 0;
+    c->gap = 0.0;
+    c->budget = NULL;
+
     /* Common */
-    c->status = -1;
+    c->status = status_unsolved;
     c->execution_time = 0.0;
     c->memory_required = matrix_sizeof(c->restrictions) +
-                         (num_vars * sizeof(int)) +
+                         (num_vars * (sizeof(number) + sizeof(int))) +
                          sizeof(bip_context);
     c->report_buffer = tmpfile();
     if(c->report_buffer == NULL) {
         matrix_free(c->restrictions);
         free(c->function);
+        free(c->candidate);
         free(c);
         return NULL;
     }
+    stats_init(&c->stats);
+
+    return c;
+}
+
+bip_context* bip_context_new_sparse(int num_vars, sparse* rests)
+{
+    /* Check input is correct */
+    if((rests == NULL) || (rests->columns != num_vars)) {
+        return NULL;
+    }
+
+    bip_context* c = bip_context_new(num_vars, 0);
+    if(c == NULL) {
+        return NULL;
+    }
+
+    /* Try to allocate dynamic memory */
+    int m = rests->rows;
+    c->types = (int*) malloc((m + 1) * sizeof(int));
+    c->equls = (number*) malloc((m + 1) * sizeof(number));
+    if((c->types == NULL) || (c->equls == NULL)) {
+        bip_context_free(c);
+        return NULL;
+    }
+
+    /* Save restrictions */
+    c->num_rest = m;
+    c->sparse_rests = rests;
+    c->memory_required += sparse_sizeof(rests) +
+                          (m * (sizeof(int) + sizeof(number)));
 
     return c;
 }
 
+bool bip_context_sparsify(bip_context* c)
+{
+    if(c->sparse_rests != NULL) {
+        return true;
+    }
+    if(c->restrictions == NULL) {
+        return false;
+    }
+
+    /* Check density */
+    int n = c->num_vars;
+    int m = c->num_rest;
+    int nnz = matrix_nnz(c->restrictions, n);
+    if(nnz >= SPARSE_DENSITY * n * m) {
+        return false;
+    }
+
+    /* Try to allocate dynamic memory, keep it dense on failure */
+    sparse* s = sparse_from_matrix(c->restrictions, n);
+    int* types = (int*) malloc((m + 1) * sizeof(int));
+    number* equls = (number*) malloc((m + 1) * sizeof(number));
+    if((s == NULL) || (types == NULL) || (equls == NULL)) {
+        sparse_free(s);
+        free(types);
+        free(equls);
+        return false;
+    }
+
+    /* Unpack types and equalities */
+    for(int i = 0; i < m; i++) {
+        types[i] = (int) c->restrictions->data[i][n];
+        equls[i] = c->restrictions->data[i][n + 1];
+    }
+
+    /* Swap storage */
+    c->memory_required = c->memory_required -
+                         matrix_sizeof(c->restrictions) + sparse_sizeof(s) +
+                         (m * (sizeof(int) + sizeof(number)));
+    matrix_free(c->restrictions);
+    c->restrictions = NULL;
+    c->sparse_rests = s;
+    c->types = types;
+    c->equls = equls;
+
+    return true;
+}
+
+bip_context* bip_context_from_rows(int num_vars, int num_rest, int* starts,
+                                   int* columns, number* values, int* types,
+                                   number* equls)
+{
+    int nnz = starts[num_rest];
+
+    /* Sparse */
+    if(nnz < SPARSE_DENSITY * num_vars * num_rest) {
+
+        sparse* s = sparse_new(num_rest, num_vars, nnz);
+        if(s == NULL) {
+            return NULL;
+        }
+        memcpy(s->row_start, starts, num_rest * sizeof(int));
+        memcpy(s->row_column, columns, nnz * sizeof(int));
+        memcpy(s->row_value, values, nnz * sizeof(number));
+        sparse_index(s);
+
+        bip_context* c = bip_context_new_sparse(num_vars, s);
+        if(c == NULL) {
+            sparse_free(s);
+            return NULL;
+        }
+        memcpy(c->types, types, num_rest * sizeof(int));
+        memcpy(c->equls, equls, num_rest * sizeof(number));
+        return c;
+    }
+
+    /* Dense */
+    bip_context* c = bip_context_new(num_vars, num_rest);
+    if(c == NULL) {
+        return NULL;
+    }
+    for(int i = 0; i < num_rest; i++) {
+        number* rests = c->restrictions->data[i];
+        for(int k = starts[i]; k < starts[i + 1]; k++) {
+            rests[columns[k]] = values[k];
+        }
+        rests[num_vars] = types[i];
+        rests[num_vars + 1] = equls[i];
+    }
+    return c;
+}
+
 void bip_context_free(bip_context* c)
 {
     matrix_free(c->restrictions);
+    sparse_free(c->sparse_rests);
+    free(c->types);
+    free(c->equls);
     fclose(c->report_buffer);
     free(c->function);
+    free(c->candidate);
+    stats_clear(&c->stats);
     free(c);
     return;
 }
 
-bool implicit_enumeration(bip_context* c)
+/* Traced search, logs every node to the report buffer */
+#define IMPL_TRACE 1
+#define IMPL_PARALLEL 0
+#define IMPL_QUEUE 0
+#define IMPL_NAME(name) name##_traced
+#include "implicit.inc"
+#undef IMPL_NAME
+#undef IMPL_QUEUE
+#undef IMPL_PARALLEL
+#undef IMPL_TRACE
+
+/* Headless search, no report work at all */
+#define IMPL_TRACE 0
+#define IMPL_PARALLEL 0
+#define IMPL_QUEUE 0
+#define IMPL_NAME(name) name##_headless
+#include "implicit.inc"
+#undef IMPL_NAME
+#undef IMPL_QUEUE
+#undef IMPL_PARALLEL
+#undef IMPL_TRACE
+
+/* Headless search deferring nodes to a queue of open nodes */
+#define IMPL_TRACE 0
+#define IMPL_PARALLEL 0
+#define IMPL_QUEUE 1
+#define IMPL_NAME(name) name##_queued
+#include "implicit.inc"
+#undef IMPL_NAME
+#undef IMPL_QUEUE
+#undef IMPL_PARALLEL
+#undef IMPL_TRACE
+
+/**
+ * Perform the Implicit Enumeration on this thread.
+ *
+ * @return the number of nodes evaluated or -1 if enough memory could not be
+ *         allocated.
+ */
+static long impl_sequential(bip_context* c, number* alpha,
+                            assignment* candidate)
 {
-    /* Start counting time */
-    GTimer* timer = g_timer_new();
+    int v = c->num_vars;
 
-    /* Variables */
+    /* Try to allocate memory */
+    activity* a = activity_new(c);
+    if(a == NULL) {
+        return -1;
+    }
+    impl_frame* stack = (impl_frame*) malloc((v + 1) * sizeof(impl_frame));
+    if(stack == NULL) {
+        activity_free(a);
+        return -1;
+    }
+    if(c->cache && !c->trace) {
+        a->cache = cache_new(c);
+        if(a->cache == NULL) {
+            activity_free(a);
+            free(stack);
+            return -1;
+        }
+    }
+
+    /* Vectors for the report, only needed if tracing */
+    int* fixed = NULL;
+    int* workplace = NULL;
+    int* parents = NULL;
+    int* branched = NULL;
+    if(c->trace) {
+        fixed = (int*) malloc(v * sizeof(int));
+        workplace = (int*) malloc(v * sizeof(int));
+        parents = (int*) malloc((v + 1) * sizeof(int));
+        branched = (int*) malloc((v + 1) * sizeof(int));
+        if((fixed == NULL) || (workplace == NULL) || (parents == NULL) ||
+           (branched == NULL)) {
+            activity_free(a);
+            free(stack);
+            free(fixed);
+            free(workplace);
+            free(parents);
+            free(branched);
+            return -1;
+        }
+        for(int i = 0; i < v; i++) {
+            workplace[i] = -1;
+            parents[i]   = -1;
+            branched[i]  = -1;
+        }
+        parents[v] = -1;
+        branched[v] = -1;
+    }
+    long reserved = activity_sizeof(a) + ((v + 1) * sizeof(impl_frame));
+    if(c->trace) {
+        reserved += ((4 * v) + 2) * sizeof(int);
+    }
+    budget_reserve(c->budget, reserved);
+
+    /* Solve problem */
+    long nodes = 0;
+    if(c->trace) {
+        nodes = impl_search_traced(c, a, alpha, candidate, fixed, workplace,
+                                   parents, branched, stack, 0, 1, v + 1,
+                                   NULL);
+    } else {
+        nodes = impl_search_headless(c, a, alpha, candidate, NULL, NULL, NULL,
+                                     NULL, stack, 0, 1, v + 1, NULL);
+    }
+
+    budget_reserve(c->budget, -reserved);
+    stats_merge(&c->stats, &a->stats, 0, c->maximize);
+    activity_free(a);
+    free(stack);
+    free(fixed);
+    free(workplace);
+    free(parents);
+    free(branched);
+    return nodes;
+}
+
+/**
+ * Perform the Implicit Enumeration on this thread, taking the open nodes
+ * from a priority queue. Each node taken is explored depth first down to
+ * a few levels below it (one if not hybrid), and the nodes found there go
+ * back to the queue.
+ *
+ * @return the number of nodes evaluated or -1 if enough memory could not be
+ *         allocated.
+ */
+static long impl_best_first(bip_context* c, number* alpha,
+                            assignment* candidate)
+{
     int v = c->num_vars;
-    int alpha = INT_MAX;
-    if(c->maximize) {
-        alpha = INT_MIN;
+    int plunge = (c->selection == select_hybrid) ? QUEUE_PLUNGE : 1;
+
+    /* Try to allocate memory, the nodes taken are at depth 1 */
+    activity* a = activity_new(c);
+    node_queue* q = queue_new(c);
+    impl_frame* stack = (impl_frame*) malloc((v + 2) * sizeof(impl_frame));
+    if((a == NULL) || (q == NULL) || (stack == NULL)) {
+        activity_free(a);
+        queue_free(q);
+        free(stack);
+        return -1;
     }
 
-    /* Try to allocate memory */
-    int* fixed = (int*) malloc(v * sizeof(int));
-    if(fixed == NULL) {
-        return false;
+    /* The queue is counted as it grows */
+    long reserved = activity_sizeof(a) + ((v + 2) * sizeof(impl_frame));
+    budget_reserve(c->budget, reserved);
+    long queued = queue_sizeof(q);
+    budget_reserve(c->budget, queued);
+
+    long nodes = impl_search_queued(c, a, alpha, candidate, NULL, NULL, NULL,
+                                    NULL, stack, 0, 1, plunge, q);
+
+    queue_entry e;
+    while(queue_pop(q, a, &e)) {
+
+        /* A limit was hit, the nodes left in the queue stay open */
+        budget_reserve(c->budget, (long) queue_sizeof(q) - queued);
+        queued = queue_sizeof(q);
+        if(budget_check(c->budget)) {
+            budget_open(c->budget, e.bound, c->maximize);
+            for(int k = 0; k < q->size; k++) {
+                budget_open(c->budget, q->heap[k].bound, c->maximize);
+            }
+            break;
+        }
+
+        /* Plunges are too short for the searches to report the progress */
+        search_progress p;
+        if(budget_due(c->budget, &p)) {
+            impl_progress_queued(c, a, alpha, stack, 1, 1, q, &p);
+            budget_report(c->budget, &p);
+        }
+
+        /* The bound of the node can't be beaten anymore. In best bound
+         * order neither can the bound of the rest. */
+        if((c->maximize && (e.bound <= *alpha)) ||
+           (!c->maximize && (e.bound >= *alpha))) {
+            if(c->selection != select_estimate) {
+                queue_clear(q);
+            }
+            continue;
+        }
+
+        stack[0].var = e.var;
+        stack[0].bf = e.bf;
+        nodes += impl_search_queued(c, a, alpha, candidate, NULL, NULL, NULL,
+                                    NULL, stack, 1, nodes + 1, 1 + plunge, q);
     }
-    int* workplace = (int*) malloc(v * sizeof(int));
-    if(workplace == NULL) {
-        free(fixed);
-        return false;
+
+    budget_reserve(c->budget, -(reserved + queued));
+    stats_merge(&c->stats, &a->stats, 0, c->maximize);
+    activity_free(a);
+    queue_free(q);
+    free(stack);
+    return nodes;
+}
+
+/**
+ * Copy the options of a context to a derived one.
+ */
+static void copy_options(bip_context* c, bip_context* r)
+{
+    r->trace = c->trace;
+    r->threads = c->threads;
+    r->deterministic = c->deterministic;
+    r->presolve = c->presolve;
+    r->propagate = c->propagate;
+    r->relaxation = c->relaxation;
+    r->symmetry = c->symmetry;
+    r->cuts = c->cuts;
+    r->branching = c->branching;
+    r->value_order = c->value_order;
+    r->selection = c->selection;
+    r->queue_memory = c->queue_memory;
+    r->nogoods = c->nogoods;
+    r->cache = c->cache;
+    r->cache_memory = c->cache_memory;
+    r->eviction = c->eviction;
+    r->heuristics = c->heuristics;
+    r->heuristics_time = c->heuristics_time;
+    r->node_limit = c->node_limit;
+    r->time_limit = c->time_limit;
+    r->memory_limit = c->memory_limit;
+    r->budget = c->budget;
+}
+
+static bool impl_solve(bip_context* c);
+
+/**
+ * Add the time since 'since' to a phase of the resolution.
+ *
+ * @return the time now, the start of the next phase.
+ */
+static double timed(bip_context* c, enum SearchPhase phase, double since)
+{
+    double now = budget_elapsed(c->budget);
+    c->stats.phases[phase] += now - since;
+    return now;
+}
+
+/**
+ * Search the model strengthened with symmetry breaking restrictions or with
+ * root cuts, it has the same variables so its result is copied as is. Cuts
+ * are still separated after breaking the symmetry, but not again.
+ */
+static bool impl_strengthened(bip_context* c, bip_context* s, bool cut)
+{
+    copy_options(c, s);
+    s->presolve = false;
+    s->symmetry = false;
+    s->cuts = c->cuts && !cut;
+
+    budget_reserve(c->budget, s->memory_required);
+    bool success = impl_solve(s);
+    budget_reserve(c->budget, -(long) s->memory_required);
+    stats_merge(&c->stats, &s->stats, 0, c->maximize);
+    if(success) {
+        memcpy(c->candidate, s->candidate, c->num_vars * sizeof(int));
+        c->alpha = s->alpha;
+        c->nodes = s->nodes;
+        c->stopped = s->stopped;
+        c->bound = s->bound;
+    }
+    return success;
+}
+
+/**
+ * Search the model and save the result in the context.
+ */
+static bool impl_solve(bip_context* c)
+{
+    double clock = budget_elapsed(c->budget);
+
+    /* Search the model with interchangeable variables ordered instead */
+    if(c->symmetry && !c->trace) {
+        bip_context* s = symmetry_break(c);
+        clock = timed(c, phase_symmetry, clock);
+        if(s != NULL) {
+            bool success = impl_strengthened(c, s, false);
+            bip_context_free(s);
+            return success;
+        }
+    }
+
+    /* Search the model with root cuts instead, if any is found */
+    if(c->cuts && c->relaxation && !c->trace) {
+        bip_context* s = cuts_separate(c);
+        clock = timed(c, phase_cuts, clock);
+        if(s != NULL) {
+            bool success = impl_strengthened(c, s, true);
+            bip_context_free(s);
+            return success;
+        }
+    }
+
+    /* Variables */
+    number alpha = NUMBER_MAX;
+    if(c->maximize) {
+        alpha = NUMBER_MIN;
     }
-    int* candidate = (int*) malloc(v * sizeof(int));
+
+    /* Try to allocate memory */
+    assignment* candidate = assignment_new(c->num_vars);
     if(candidate == NULL) {
-        free(fixed);
-        free(workplace);
         return false;
     }
-    int* parents = (int*) malloc(v * sizeof(int));
-    if(parents == NULL) {
-        free(fixed);
-        free(workplace);
-        free(candidate);
-        return false;
+
+    /* Start with a solution, the search only looks for better ones */
+    if(c->heuristics && !c->trace) {
+        heuristics_run(c, &alpha, candidate);
+        clock = timed(c, phase_heuristics, clock);
+        if(assignment_count(candidate) > 0) {
+            stats_improved(&c->stats, clock, alpha);
+        }
     }
 
-    /* Initialize vectors */
-    for(int i = 0; i < v; i++) {
-        fixed[i]     = -1;
-        workplace[i] = -1;
-        candidate[i] = -1;
-        parents[i]   = -1;
+    /* Solve problem, the trace is a single stream so it is only parallel
+     * if the order of the nodes is deterministic */
+    long nodes = 0;
+    double traced = c->stats.phases[phase_report];
+    if((parallel_threads(c) <= 1) || (c->trace && !c->deterministic)) {
+        if((c->selection != select_depth) && !c->trace) {
+            nodes = impl_best_first(c, &alpha, candidate);
+        } else {
+            nodes = impl_sequential(c, &alpha, candidate);
+        }
+    } else {
+        nodes = parallel_enumeration(c, &alpha, candidate);
     }
+    timed(c, phase_search, clock);
 
-    /* Solve problem */
-    int node = 1;
-    impl_aux(c, fixed, &alpha, workplace, candidate, parents, 0, &node);
+    /* Less the report of each node, written by the traced search */
+    c->stats.phases[phase_search] -= c->stats.phases[phase_report] - traced;
+    if(nodes < 0) {
+        assignment_free(candidate);
+        return false;
+    }
 
-    /* Check if problem was solved */
+    /* Save the result, all -1 if no candidate was found */
+    assignment_to_vector(candidate, c->candidate);
     DEBUG("Problem resolution ended with the coefficients:\n");
     for(int i = 0; i < c->num_vars; i++) {
-        DEBUG("%i ", candidate[i]);
+        DEBUG("%i ", c->candidate[i]);
     }
     DEBUG("\n");
-    /* FIXMEFIXME */
+    c->alpha = alpha;
+    c->nodes = nodes;
+    c->stopped = budget_result(c->budget, alpha, c->maximize, &c->bound);
 
-    /* Stop counting time */
-    g_timer_stop(timer);
-    c->execution_time = g_timer_elapsed(timer, NULL);
-    g_timer_destroy(timer);
+    assignment_free(candidate);
     return true;
 }
 
-void impl_aux(bip_context* c, int* fixed, int* alpha, int* workplace,
-              int* candidate, int* parents, int level, int* node)
+/**
+ * Presolve the model, search the reduced one and map its result back.
+ */
+static bool impl_presolved(bip_context* c)
 {
-    if(level == c->num_vars) {
-        return;
+    double clock = budget_elapsed(c->budget);
+    presolved* p = presolve_new(c);
+    timed(c, phase_presolve, clock);
+    if(p == NULL) {
+        return false;
     }
 
-    /* Register node num */
-    int c_node = (*node);
-    (*node) = c_node + 1;
-    parents[level] = c_node;
-    imp_node_open(c, fixed, parents, c_node);
-
-    /* Calculate best fit and test if performance is improved */
-    int bf = best_fit(c, fixed, workplace);
-    imp_node_log_bf(c, fixed, workplace, bf, *alpha); /* LOG */
-    if((c->maximize && (bf <= *alpha)) || (!c->maximize && (bf >= *alpha))) {
-        DEBUG("Node %i: Close node. Doesn't improve performance.\n", c_node);
-        imp_node_close(c, doesnt_improve); /* LOG */
-        return;
+    /* Not factible until a candidate is found */
+    c->alpha = c->maximize ? NUMBER_MIN : NUMBER_MAX;
+    c->nodes = 0;
+    c->stopped = stop_none;
+    for(int i = 0; i < c->num_vars; i++) {
+        c->candidate[i] = -1;
     }
 
-    /* Check factibility */
-    imp_node_log_rc(c); /* LOG */
-    bool fact = check_restrictions(c, workplace);
-    if(fact) {
-
-        /* Set the solution as new candidate */
-        for(int i = 0; i < c->num_vars; i++) {
-            candidate[i] = workplace[i];
+    bool success = true;
+    if(p->infeasible) {
+        DEBUG("Presolve: the model is not factible.\n");
+
+    } else if(p->reduced == NULL) {
+        presolve_restore(p, NULL, c->candidate);
+        c->alpha = p->offset;
+        stats_improved(&c->stats, budget_elapsed(c->budget), c->alpha);
+
+    } else {
+        bip_context* r = p->reduced;
+        copy_options(c, r);
+        r->trace = false;
+        r->presolve = false;
+        if(c->budget != NULL) {
+            c->budget->offset = p->offset;
         }
 
-        /* Set alpha as the new performance */
-        (*alpha) = bf;
-
-        DEBUG("Node %i: Close node. New candidate solution: %i.\n", c_node, bf);
-        imp_node_close(c, new_candidate); /* LOG */
-        return;
+        budget_reserve(c->budget, r->memory_required);
+        success = impl_solve(r);
+        budget_reserve(c->budget, -(long) r->memory_required);
+        stats_merge(&c->stats, &r->stats, p->offset, c->maximize);
+        if(success && (r->candidate[0] != -1)) {
+            presolve_restore(p, r->candidate, c->candidate);
+            c->alpha = r->alpha + p->offset;
+        }
+        c->nodes = r->nodes;
+        c->stopped = r->stopped;
+        if(r->stopped != stop_none) {
+            c->bound = r->bound + p->offset;
+        }
     }
 
-    /* Not factible, check possible future factibility */
-    imp_node_log_ff(c);
-    bool future_fact = check_future_fact(c, fixed, workplace);
-    if(!future_fact) {
-        DEBUG("Node %i: Close node. Not factible.\n", c_node);
-        imp_node_close(c, not_factible); /* LOG */
-        return;
-    }
+    presolve_free(p);
+    return success;
+}
 
-    DEBUG("Node %i: Expand node. Possible future factibility.\n", c_node);
-    imp_node_close(c, expand); /* LOG */
+/**
+ * Add the magnitude of a coefficient to a sum.
+ *
+ * @return FALSE if the sum exceeds half of NUMBER_LIMIT.
+ */
+static bool add_magnitude(number* sum, number coeff)
+{
+    bool fits = (coeff < 0) ? number_sub(*sum, coeff, sum) :
+                              number_add(*sum, coeff, sum);
+    return fits && (*sum <= NUMBER_LIMIT / 2);
+}
 
-    fixed[level] = 0;
-    impl_aux(c, fixed, alpha, workplace, candidate, parents, level + 1, node);
-    for(int i = level + 1; i < c->num_vars; i++) {
-        fixed[i] = -1;
-        parents[i] = -1;
+/**
+ * Check that no activity or performance of the model can overflow. The
+ * magnitudes of the objective and of each restriction, with its equality,
+ * are summed with checked arithmetic. If no sum exceeds half of NUMBER_LIMIT,
+ * any activity or performance is in range and so is the difference of two
+ * of them, so the search itself needs no checks.
+ */
+static bool in_range(bip_context* c)
+{
+    number sum = 0;
+    for(int j = 0; j < c->num_vars; j++) {
+        if(!add_magnitude(&sum, c->function[j])) {
+            return false;
+        }
     }
 
-    fixed[level] = 1;
-    impl_aux(c, fixed, alpha, workplace, candidate, parents, level + 1, node);
-    for(int i = level + 1; i < c->num_vars; i++) {
-        fixed[i] = -1;
-        parents[i] = -1;
+    sparse* s = c->sparse_rests;
+    for(int i = 0; i < c->num_rest; i++) {
+        sum = 0;
+        if(!add_magnitude(&sum, rest_equl(c, i))) {
+            return false;
+        }
+        if(s != NULL) {
+            for(int k = s->row_start[i]; k < s->row_start[i + 1]; k++) {
+                if(!add_magnitude(&sum, s->row_value[k])) {
+                    return false;
+                }
+            }
+            continue;
+        }
+        for(int j = 0; j < c->num_vars; j++) {
+            if(!add_magnitude(&sum, c->restrictions->data[i][j])) {
+                return false;
+            }
+        }
     }
+    return true;
+}
 
-    return;
+/**
+ * Relative distance between the best solution found and the bound of the
+ * optimum.
+ *
+ * @return the gap, 0 if the solution is optimal or HUGE_VAL if there is no
+ *         solution.
+ */
+static double relative_gap(bip_context* c)
+{
+    if(c->candidate[0] == -1) {
+        return (c->stopped == stop_none) ? 0.0 : HUGE_VAL;
+    }
+    double distance = fabs((double) c->bound - (double) c->alpha);
+    return distance / fmax(fabs((double) c->alpha), 1.0);
 }
 
-int reset_workplace(bip_context* c, int* fixed, int* workplace)
+bool implicit_enumeration(bip_context* c)
 {
-    /* Copy fixed variables to the workplace */
-    int i = 0;
-    for(; i < c->num_vars; i++) {
-        int n = fixed[i];
-        if(n == -1) {
-            break;
-        }
-        workplace[i] = n;
+    if(!in_range(c)) {
+        c->status = status_out_of_range;
+        return false;
     }
 
-    for(int j = i; j < c->num_vars; j++) {
-        workplace[j] = -1;
+    /* Start counting time */
+    c->budget = budget_new(c->node_limit, c->time_limit, c->memory_limit);
+    if(c->budget == NULL) {
+        c->status = status_no_memory;
+        return false;
+    }
+    budget_watch(c->budget, &c->cancel, c->progress, c->progress_data,
+                 c->progress_interval);
+    stats_reset(&c->stats);
+
+    /* The report follows the model as given, so it is never presolved */
+    bool success = false;
+    if(c->presolve && !c->trace) {
+        success = impl_presolved(c);
+    } else {
+        success = impl_solve(c);
+    }
+
+    /* Stop counting time */
+    g_timer_stop(c->budget->timer);
+    c->execution_time = g_timer_elapsed(c->budget->timer, NULL);
+    c->stats.peak_memory = c->memory_required + c->budget->peak;
+    budget_free(c->budget);
+    c->budget = NULL;
+
+    if(c->stopped == stop_none) {
+        c->bound = c->alpha;
     }
+    c->gap = relative_gap(c);
 
-    return i;
+    /* Every other failure is an allocation */
+    c->status = success ? status_solved : status_no_memory;
+    return success;
 }
 
-int dot_product(int* vector1, int* vector2, int size)
+void bip_cancel(bip_context* c)
 {
-    int dp = 0;
+    g_atomic_int_set(&c->cancel, 1);
+}
+
+number dot_product(number* vector1, int* vector2, int size)
+{
+    number dp = 0;
     for(int i = 0; i < size; i++) {
         dp = dp + (vector1[i] * vector2[i]);
     }
     return dp;
 }
 
-int best_fit(bip_context* c, int* fixed, int* workplace)
+number best_fit(bip_context* c, int* fixed, int* workplace)
 {
-    /* Flush fixed to workplace */
-    int i = reset_workplace(c, fixed, workplace);
-
-    /* Set the free variables to the best fit */
+    /* Set the free variables to the best fit, fixed ones can be anywhere */
     int for_pos = 0;
     int for_neg = 1;
     if(c->maximize) {
@@ -257,9 +814,11 @@ int best_fit(bip_context* c, int* fixed, int* workplace)
         for_neg = 0;
     }
 
-    for(; i < c->num_vars; i++) {
-        int n = c->function[i];
-        if(n > 0) {
+    for(int i = 0; i < c->num_vars; i++) {
+        number n = c->function[i];
+        if(fixed[i] != -1) {
+            workplace[i] = fixed[i];
+        } else if(n > 0) {
             workplace[i] = for_pos;
         } else if(n < 0) {
             workplace[i] = for_neg;
@@ -272,100 +831,96 @@ int best_fit(bip_context* c, int* fixed, int* workplace)
     return dot_product(c->function, workplace, c->num_vars);
 }
 
-bool check_restrictions(bip_context* c, int* vars)
+number rest_coeff(bip_context* c, int i, int j)
 {
-    if(c->restrictions == NULL) {
-        return true;
+    if(c->sparse_rests != NULL) {
+        return sparse_get(c->sparse_rests, i, j);
     }
+    return c->restrictions->data[i][j];
+}
 
-    bool fact = true;
+int rest_type(bip_context* c, int i)
+{
+    if(c->sparse_rests != NULL) {
+        return c->types[i];
+    }
+    return (int) c->restrictions->data[i][c->num_vars];
+}
 
-    for(int i = 0; fact && (i < c->num_rest); i++) {
+number rest_equl(bip_context* c, int i)
+{
+    if(c->sparse_rests != NULL) {
+        return c->equls[i];
+    }
+    return c->restrictions->data[i][c->num_vars + 1];
+}
 
-        int* rests = c->restrictions->data[i];
-        int type = rests[c->num_vars];
-        int equl = rests[c->num_vars + 1];
+number rest_dot(bip_context* c, int i, int* vars)
+{
+    if(c->sparse_rests == NULL) {
+        return dot_product(c->restrictions->data[i], vars, c->num_vars);
+    }
 
-        int real = dot_product(rests, vars, c->num_vars);
+    sparse* s = c->sparse_rests;
+    number dp = 0;
+    for(int k = s->row_start[i]; k < s->row_start[i + 1]; k++) {
+        dp = dp + (s->row_value[k] * vars[s->row_column[k]]);
+    }
+    return dp;
+}
 
-        if(type == GE) {
-            fact = fact && (real >= equl);
-            imp_node_log_calc(c, rests, vars, fact, i); /* LOG */
-            continue;
-        }
+bool check_restriction(bip_context* c, int i, int* vars)
+{
+    int type = rest_type(c, i);
+    number equl = rest_equl(c, i);
 
-        if(type == LE) {
-            fact = fact && (real <= equl);
-            imp_node_log_calc(c, rests, vars, fact, i); /* LOG */
-            continue;
-        }
+    number real = rest_dot(c, i, vars);
 
-        fact = fact && (real == equl);
-        imp_node_log_calc(c, rests, vars, fact, i); /* LOG */
+    if(type == GE) {
+        return real >= equl;
     }
-
-    return fact;
+    if(type == LE) {
+        return real <= equl;
+    }
+    return real == equl;
 }
 
-bool check_future_fact(bip_context* c, int* fixed, int* workplace)
+bool check_future_rest(bip_context* c, int i, int* fixed, int* workplace)
 {
-    if(c->restrictions == NULL) {
-        return true;
-    }
-
-    bool fact = true;
-    for(int i = 0; fact && (i < c->num_rest); i++) {
-
-        /* Flush fixed to workplace */
-        int j = reset_workplace(c, fixed, workplace);
+    /* Flush fixed to workplace */
+    memcpy(workplace, fixed, c->num_vars * sizeof(int));
 
-        int* rests = c->restrictions->data[i];
-        int type = rests[c->num_vars];
-        int equl = rests[c->num_vars + 1];
+    int type = rest_type(c, i);
+    number equl = rest_equl(c, i);
 
-        /* Calculate margins */
-        int top = INT_MAX;
-        if((type == GE) || (type == EQ)) {
+    /* Calculate margins */
+    number top = NUMBER_MAX;
+    if((type == GE) || (type == EQ)) {
 
-            /* Set free variables */
-            for(int k = j; k < c->num_vars; k++) {
-                int n = rests[k];
-                if(n > 0) {
-                    workplace[k] = 1;
-                } else if(n < 0) {
-                    workplace[k] = 0;
-                } else {
-                    workplace[k] = 0;
-                }
+        /* Set free variables */
+        for(int k = 0; k < c->num_vars; k++) {
+            if(fixed[k] == -1) {
+                workplace[k] = rest_coeff(c, i, k) > 0 ? 1 : 0;
             }
-
-            /* Calculate scalar product */
-            top = dot_product(rests, workplace, c->num_vars);
         }
 
-        int bottom = INT_MIN;
-        if((type == LE) || (type == EQ)) {
-
-            /* Set free variables */
-            for(int k = j; k < c->num_vars; k++) {
-                int n = rests[k];
-                if(n > 0) {
-                    workplace[k] = 0;
-                } else if(n < 0) {
-                    workplace[k] = 1;
-                } else {
-                    workplace[k] = 0;
-                }
-            }
+        /* Calculate scalar product */
+        top = rest_dot(c, i, workplace);
+    }
 
-            /* Calculate scalar product */
-            bottom = dot_product(rests, workplace, c->num_vars);
+    number bottom = NUMBER_MIN;
+    if((type == LE) || (type == EQ)) {
+
+        /* Set free variables */
+        for(int k = 0; k < c->num_vars; k++) {
+            if(fixed[k] == -1) {
+                workplace[k] = rest_coeff(c, i, k) < 0 ? 1 : 0;
+            }
         }
 
-        fact = fact && (bottom <= equl) && (equl <= top);
-        imp_node_log_calc(c, rests, workplace, fact, i); /* LOG */
+        /* Calculate scalar product */
+        bottom = rest_dot(c, i, workplace);
     }
 
-    return fact;
+    return (bottom <= equl) && (equl <= top);
 }
-
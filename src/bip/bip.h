@@ -21,51 +21,209 @@
 
 #include "utils.h"
 #include "matrix.h"
+#include "sparse.h"
+#include "budget.h"
+#include "stats.h"
 
 #define LE -1
 #define GE  1
 #define EQ  0
 
+/* Models with less nonzero coefficients than this are stored sparse */
+#define SPARSE_DENSITY 0.2
+
+/* Order in which open nodes are explored, see queue.h */
+enum NodeSelection {
+    select_depth,       /* Depth first */
+    select_bound,       /* Best bound first */
+    select_estimate,    /* Best estimate first */
+    select_hybrid       /* Depth first plunges from the best bound */
+};
+
+/* Rules to select the variable to branch on, see branch.h */
+enum BranchRule {
+    branch_first,
+    branch_constrained,
+    branch_objective,
+    branch_pseudocost,
+    branch_strong
+};
+
+/* Entry of a full bucket a new one replaces in the transposition cache, see
+ * cache.h */
+enum CacheEviction {
+    evict_oldest,       /* Stored or found the longest ago */
+    evict_smallest      /* With the subtree that took the fewest nodes */
+};
+
+/* Outcome of the last resolution of a context, in 'status' */
+enum SolveStatus {
+    status_unsolved = -1,
+    status_solved,
+    status_no_memory,       /* Enough memory could not be allocated */
+    status_out_of_range     /* Coefficients too big for the type, see
+                             * matrix.h */
+};
+
 /**
  * Binary integer programming context data structure.
  */
 typedef struct {
 
     /* Common */
-    int status;
+    int status;     /* enum SolveStatus */
     double execution_time;
-    unsigned int memory_required;
+    unsigned int memory_required;   /* Of the model, see 'stats' */
     FILE* report_buffer;
 
     /* Data */
     int num_vars;
     bool maximize;
-    int* function;
+    number* function;
     int num_rest;
+
+    /* Restrictions are either dense, with the type and the equality in the
+     * last two columns, or sparse, with types and equalities apart. */
     matrix* restrictions;
+    sparse* sparse_rests;
+    int* types;
+    number* equls;
+
+    /* Options */
+    bool trace;     /* Log every node, see implicit.inc */
+    int threads;    /* Workers of the search, 0 for one per processor,
+                     * see parallel.h */
+    bool deterministic; /* Same result in every run, see parallel.h */
+    bool presolve;  /* Reduce the model first, not when tracing, see
+                     * presolve.h */
+    bool propagate; /* Fix forced variables at each node, not when
+                     * tracing, see activity.h */
+    bool relaxation;    /* Bound nodes with the LP relaxation, see lp.h */
+    bool symmetry;      /* Order interchangeable variables, not when
+                         * tracing, see symmetry.h */
+    bool cuts;          /* Tighten the relaxation at the root, not when
+                         * tracing, see cuts.h */
+    enum BranchRule branching;
+    bool value_order;   /* Try the value of the best fit first */
+    enum NodeSelection selection;   /* Not when tracing or in parallel */
+    unsigned int queue_memory;  /* Bytes for the open nodes */
+    int nogoods;        /* Kept by each worker, 0 not to learn them, see
+                         * nogood.h */
+    bool cache;         /* Remember explored subtrees, only depth first
+                         * and sequential, see cache.h */
+    unsigned int cache_memory;  /* Bytes for them */
+    enum CacheEviction eviction;
+    bool heuristics;    /* Look for a solution first, not when tracing,
+                         * see heuristics.h */
+    double heuristics_time;     /* Seconds for it */
+    long node_limit;    /* 0 for no limit, see budget.h */
+    double time_limit;  /* Seconds, 0 for no limit */
+    unsigned int memory_limit;  /* Bytes for the search, 0 for no limit */
+    progress_hook progress;     /* NULL not to report the progress */
+    void* progress_data;
+    double progress_interval;   /* Seconds, 0 for BUDGET_INTERVAL */
+
+    /* Control, set from other threads with bip_cancel() */
+    int cancel;
+
+    /* Result */
+    number alpha;
+    int* candidate;
+    long nodes;
+    enum SearchStop stopped;
+    number bound;       /* Of the optimum, alpha if not stopped */
+    double gap;
+    search_stats stats;
+
+    /* Limits of the resolution in progress, shared by derived contexts */
+    search_budget* budget;
 
 } bip_context;
 
 bip_context* bip_context_new(int num_vars, int num_rest);
 void bip_context_free(bip_context* c);
 
+/**
+ * Create a context with sparse restrictions.
+ *
+ * @param num_vars, the number of variables.
+ * @param rests, the coefficients of the restrictions. The context takes
+ *        ownership of it.
+ * @return a pointer to the context with 'types' and 'equls' allocated but not
+ *         initialized, or NULL if enough memory could not be allocated.
+ */
+bip_context* bip_context_new_sparse(int num_vars, sparse* rests);
+
+/**
+ * Switch a context to sparse restrictions if they are mostly zeros.
+ *
+ * @param c, the binary integer programming context data structure.
+ * @return TRUE if the restrictions are sparse after the call.
+ */
+bool bip_context_sparsify(bip_context* c);
+
+/**
+ * Create a context from its restrictions given by rows, choosing the storage
+ * by their density. The objective function is left to the caller.
+ *
+ * @param num_vars, num_rest, the size of the model.
+ * @param starts, the first nonzero of each row, plus the total in
+ *        starts[num_rest].
+ * @param columns, values, the column and the value of each nonzero, sorted by
+ *        column within a row.
+ * @param types, equls, the type and the equality of each restriction.
+ * @return a pointer to the new context or NULL if enough memory could not be
+ *         allocated.
+ */
+bip_context* bip_context_from_rows(int num_vars, int num_rest, int* starts,
+                                   int* columns, number* values, int* types,
+                                   number* equls);
+
+/**
+ * Access the restrictions of a context regardless of their storage.
+ */
+number rest_coeff(bip_context* c, int i, int j);
+int rest_type(bip_context* c, int i);
+number rest_equl(bip_context* c, int i);
+number rest_dot(bip_context* c, int i, int* vars);
+
 /**
  * Perform Implicit Enumeration algorithm with given context.
  *
+ * The options of the context select how the model is searched, see the
+ * comment of each one and the header it refers to. If 'trace' is set every
+ * node is logged to the report buffer, most options only apply when it isn't.
+ * The search stops at the limits of the budget, see budget.h, or once
+ * bip_cancel() is called.
+ *
+ * On return 'candidate' holds the best solution found (all -1 if the problem
+ * is not factible), 'alpha' its performance, 'nodes' the number of nodes
+ * evaluated and 'stats' the statistics of the resolution, see stats.h. If the
+ * search stopped with nodes open, 'stopped' says why and 'bound' and 'gap'
+ * how far from the optimum alpha can be.
+ *
  * @param bip_context, the binary integer programming context data structure.
- * @return TRUE if execution was successful or FALSE if and error ocurred. Check
- *         'status' flag in context to know what went wrong.
+ * @return TRUE if execution was successful or FALSE if and error ocurred,
+ *         such as the coefficients being too big for the type. Check
+ *         'status' flag in context to know what went wrong, see
+ *         enum SolveStatus.
  */
 bool implicit_enumeration(bip_context* c);
 
-void impl_aux(bip_context* c, int* fixed, int* alpha, int* workplace,
-              int* candidate, int* parents, int level, int* node);
+/**
+ * Stop the resolution in progress of a context, from any thread. It stops
+ * as if a limit was hit, see implicit_enumeration(). The flag stays set, so
+ * a resolution started afterwards stops too until 'cancel' is set back to 0.
+ *
+ * @param bip_context, the binary integer programming context data structure.
+ * @return nothing
+ */
+void bip_cancel(bip_context* c);
 
-int reset_workplace(bip_context* c, int* fixed, int* workplace);
-int dot_product(int* vector1, int* vector2, int size);
+number dot_product(number* vector1, int* vector2, int size);
 
-int best_fit(bip_context* c, int* fixed, int* workplace);
-bool check_future_fact(bip_context* c, int* fixed, int* workplace);
-bool check_restrictions(bip_context* c, int* vars);
+number best_fit(bip_context* c, int* fixed, int* workplace);
+bool check_future_rest(bip_context* c, int i, int* fixed, int* workplace);
+bool check_restriction(bip_context* c, int i, int* vars);
 
 #endif
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "branch.h"
+
+/* Degradation assumed for a branch that can't be explored */
+#define BRANCH_INFEASIBLE 1000000000.0
+
+/* Degradation counted for a branch that keeps the best fit, so the product
+ * still ranks the other branch */
+#define BRANCH_EPSILON 0.000001
+
+static double product(double down, double up)
+{
+    return (down > BRANCH_EPSILON ? down : BRANCH_EPSILON) *
+           (up > BRANCH_EPSILON ? up : BRANCH_EPSILON);
+}
+
+/* Best fit degradation of each value of a variable, without probing */
+static double objective(activity* a, int var, int value)
+{
+    return (value == assignment_get(a->best, var)) ? 0.0 : fabs(a->perf[var]);
+}
+
+static int select_constrained(activity* a)
+{
+    sparse* s = a->rests;
+    int var = -1;
+    long best = -1;
+    for(int j = 0; j < a->num_vars; j++) {
+        if(assignment_get(a->fixed, j) != -1) {
+            continue;
+        }
+        long violated = 0;
+        for(int k = s->col_start[j]; k < s->col_start[j + 1]; k++) {
+            if(activity_violated(a, s->col_row[k])) {
+                violated++;
+            }
+        }
+        long score = (violated * (a->num_rest + 1)) +
+                     (s->col_start[j + 1] - s->col_start[j]);
+        if(score > best) {
+            best = score;
+            var = j;
+        }
+    }
+    return var;
+}
+
+static int select_objective(activity* a)
+{
+    int var = -1;
+    number best = -1;
+    for(int j = 0; j < a->num_vars; j++) {
+        number perf = (a->perf[j] < 0) ? -a->perf[j] : a->perf[j];
+        if((assignment_get(a->fixed, j) == -1) && (perf > best)) {
+            best = perf;
+            var = j;
+        }
+    }
+    return var;
+}
+
+static int select_pseudocost(activity* a)
+{
+    int var = -1;
+    double best = -1.0;
+    for(int j = 0; j < a->num_vars; j++) {
+        if(assignment_get(a->fixed, j) != -1) {
+            continue;
+        }
+
+        /* Branches not yet observed are estimated with the objective */
+        double cost[2];
+        for(int value = 0; value < 2; value++) {
+            int n = a->observed[(2 * j) + value];
+            cost[value] = (n > 0) ? a->pseudo[(2 * j) + value] / n :
+                                    objective(a, j, value);
+        }
+        double score = product(cost[0], cost[1]);
+        if(score > best) {
+            best = score;
+            var = j;
+        }
+    }
+    return var;
+}
+
+/* Best fit degradation of fixing a variable, BRANCH_INFEASIBLE if the
+ * branch is not factible */
+static double probe(bip_context* c, activity* a, int var, int value)
+{
+    number bf = a->fixed_perf + a->free_perf;
+    int mark = a->trail_size;
+
+    activity_fix(a, var, value);
+    bool factible = (a->unreachable == 0);
+    if(factible && c->propagate) {
+        factible = activity_propagate(a, var);
+    }
+    number delta = a->fixed_perf + a->free_perf - bf;
+    activity_undo(a, mark);
+    activity_release(a, var);
+
+    return factible ? fabs(delta) : BRANCH_INFEASIBLE;
+}
+
+static int select_strong(bip_context* c, activity* a)
+{
+    int var = -1;
+    double best = -1.0;
+    for(int j = 0; j < a->num_vars; j++) {
+        if(assignment_get(a->fixed, j) != -1) {
+            continue;
+        }
+        double down = probe(c, a, j, 0);
+        double up = probe(c, a, j, 1);
+        if((down == BRANCH_INFEASIBLE) || (up == BRANCH_INFEASIBLE)) {
+            return j;
+        }
+        double score = product(down, up);
+        if(score > best) {
+            best = score;
+            var = j;
+        }
+    }
+    return var;
+}
+
+int branch_select(bip_context* c, activity* a, int* value)
+{
+    int var = -1;
+    switch(c->branching) {
+        case branch_constrained:
+            var = select_constrained(a);
+            break;
+        case branch_objective:
+            var = select_objective(a);
+            break;
+        case branch_pseudocost:
+            var = select_pseudocost(a);
+            break;
+        case branch_strong:
+            var = select_strong(c, a);
+            break;
+        default: /* branch_first */
+            var = assignment_first_free(a->fixed);
+    }
+
+    if(var != -1) {
+        *value = c->value_order ? assignment_get(a->best, var) : 0;
+    }
+    return var;
+}
+
+void branch_observe(activity* a, int var, int value, number delta)
+{
+    a->pseudo[(2 * var) + value] += delta;
+    a->observed[(2 * var) + value]++;
+    a->pseudo_total += delta;
+    a->observations++;
+}
+
+void branch_forget(activity* a)
+{
+    for(int k = 0; k < 2 * a->num_vars; k++) {
+        a->pseudo[k] = 0.0;
+        a->observed[k] = 0;
+    }
+    a->pseudo_total = 0.0;
+    a->observations = 0;
+}
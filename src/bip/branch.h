@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_BRANCH
+#define H_BRANCH
+
+#include "bip.h"
+#include "activity.h"
+
+/**
+ * Select the variable to branch on at the current node and the value to try
+ * first, following the rule of the context:
+ *
+ *     branch_first        First free variable, in the order of the model.
+ *     branch_constrained  Free variable in the most restrictions the best
+ *                         fit violates, ties broken by its nonzeros.
+ *     branch_objective    Free variable with the largest objective
+ *                         coefficient, in absolute value.
+ *     branch_pseudocost   Free variable with the largest product of the
+ *                         average best fit degradation of its branches, as
+ *                         observed with branch_observe().
+ *     branch_strong       Free variable with the largest product of the best
+ *                         fit degradation of its branches, probed fixing
+ *                         each branch (and propagating, if enabled). A branch
+ *                         found not factible is chosen right away.
+ *
+ * If 'value_order' is set in the context the value of the best fit is tried
+ * first, which keeps the best fit of the node, otherwise 0.
+ *
+ * @param c, the binary integer programming context data structure.
+ * @param a, the activity structure at the node (by reference), left as it
+ *        was found.
+ * @param value, where to store the value to try first.
+ * @return the variable to branch on or -1 if all variables are fixed.
+ */
+int branch_select(bip_context* c, activity* a, int* value);
+
+/**
+ * Record the best fit degradation of a branch for the pseudo-costs.
+ *
+ * @param a, the activity structure (by reference)
+ * @param var, the variable branched on.
+ * @param value, the value of the branch.
+ * @param delta, the difference between the best fit of the node and the one
+ *        of the branch, in absolute value.
+ * @return nothing
+ */
+void branch_observe(activity* a, int var, int value, number delta);
+
+/**
+ * Forget the pseudo-costs observed so far.
+ *
+ * @param a, the activity structure (by reference)
+ * @return nothing
+ */
+void branch_forget(activity* a);
+
+#endif
@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "budget.h"
+
+search_budget* budget_new(long nodes, double seconds, unsigned int memory)
+{
+    search_budget* b = (search_budget*) malloc(sizeof(search_budget));
+    if(b == NULL) {
+        return NULL;
+    }
+    b->node_limit = nodes;
+    b->time_limit = seconds;
+    b->memory_limit = memory;
+    b->stop = stop_none;
+    b->period = 1;
+    g_mutex_init(&b->lock);
+    b->nodes = 0;
+    b->memory = 0;
+    b->peak = 0;
+    b->checked = 0.0;
+    b->opened = false;
+    b->open = 0;
+    b->cancel = NULL;
+    b->hook = NULL;
+    b->data = NULL;
+    b->interval = BUDGET_INTERVAL;
+    b->offset = 0;
+    b->reported = 0.0;
+    b->reported_nodes = 0;
+    b->timer = g_timer_new();
+    return b;
+}
+
+void budget_watch(search_budget* b, int* cancel, progress_hook hook,
+                  void* data, double interval)
+{
+    b->cancel = cancel;
+    b->hook = hook;
+    b->data = data;
+    if(interval > 0) {
+        b->interval = interval;
+    }
+}
+
+void budget_count(search_budget* b, long nodes)
+{
+    if(b == NULL) {
+        return;
+    }
+    g_mutex_lock(&b->lock);
+    b->nodes += nodes;
+    g_mutex_unlock(&b->lock);
+}
+
+void budget_reserve(search_budget* b, long bytes)
+{
+    if(b == NULL) {
+        return;
+    }
+    g_mutex_lock(&b->lock);
+    b->memory += bytes;
+    if(b->memory > b->peak) {
+        b->peak = b->memory;
+    }
+    g_mutex_unlock(&b->lock);
+}
+
+double budget_elapsed(search_budget* b)
+{
+    if(b == NULL) {
+        return 0.0;
+    }
+    return g_timer_elapsed(b->timer, NULL);
+}
+
+bool budget_check(search_budget* b)
+{
+    if(b == NULL) {
+        return false;
+    }
+    if(budget_stopped(b)) {
+        return true;
+    }
+
+    enum SearchStop stop = stop_none;
+    double now = g_timer_elapsed(b->timer, NULL);
+    g_mutex_lock(&b->lock);
+    if((b->node_limit > 0) && (b->nodes >= b->node_limit)) {
+        stop = stop_nodes;
+    } else if((b->memory_limit > 0) && (b->memory > b->memory_limit)) {
+        stop = stop_memory;
+    } else if((b->time_limit > 0) && (now >= b->time_limit)) {
+        stop = stop_time;
+    }
+
+    /* Scale the period to the time the last one took, at most doubling it */
+    int period = 2 * b->period;
+    double since = now - b->checked;
+    if(b->period * BUDGET_TICK < period * since) {
+        period = (int) (b->period * BUDGET_TICK / since);
+    }
+    g_atomic_int_set(&b->period, max(1, min(period, BUDGET_PERIOD)));
+    b->checked = now;
+    g_mutex_unlock(&b->lock);
+
+    /* The first limit hit is the one reported */
+    if(stop != stop_none) {
+        g_atomic_int_compare_and_exchange(&b->stop, stop_none, stop);
+    }
+    return stop != stop_none;
+}
+
+long budget_period(search_budget* b)
+{
+    if(b == NULL) {
+        return BUDGET_PERIOD;
+    }
+    long period = g_atomic_int_get(&b->period);
+    if(b->node_limit <= 0) {
+        return period;
+    }
+    g_mutex_lock(&b->lock);
+    long left = b->node_limit - b->nodes;
+    g_mutex_unlock(&b->lock);
+    if(left < 1) {
+        return 1;
+    }
+    return (left < period) ? left : period;
+}
+
+bool budget_due(search_budget* b, search_progress* p)
+{
+    if((b == NULL) || (b->hook == NULL)) {
+        return false;
+    }
+    double now = g_timer_elapsed(b->timer, NULL);
+
+    /* Only the first search to see it due reports */
+    g_mutex_lock(&b->lock);
+    bool due = (now - b->reported) >= b->interval;
+    if(due) {
+        p->nodes = b->nodes;
+        p->seconds = now;
+        p->rate = (double) (b->nodes - b->reported_nodes) /
+                  (now - b->reported);
+        b->reported = now;
+        b->reported_nodes = b->nodes;
+    }
+    g_mutex_unlock(&b->lock);
+    return due;
+}
+
+void budget_report(search_budget* b, search_progress* p)
+{
+    if(p->found) {
+        p->alpha = p->alpha + b->offset;
+    }
+    if(p->bounded) {
+        p->bound = p->bound + b->offset;
+    }
+    b->hook(p, b->data);
+}
+
+void budget_open(search_budget* b, number bf, bool maximize)
+{
+    g_mutex_lock(&b->lock);
+    if(!b->opened || (maximize && (bf > b->open)) ||
+       (!maximize && (bf < b->open))) {
+        b->open = bf;
+    }
+    b->opened = true;
+    g_mutex_unlock(&b->lock);
+}
+
+enum SearchStop budget_result(search_budget* b, number alpha, bool maximize,
+                              number* bound)
+{
+    *bound = alpha;
+    if((b == NULL) || !b->opened) {
+        return stop_none;
+    }
+    if((maximize && (b->open > alpha)) || (!maximize && (b->open < alpha))) {
+        *bound = b->open;
+    }
+    return (enum SearchStop) g_atomic_int_get(&b->stop);
+}
+
+void budget_free(search_budget* b)
+{
+    if(b == NULL) {
+        return;
+    }
+    g_timer_destroy(b->timer);
+    g_mutex_clear(&b->lock);
+    free(b);
+}
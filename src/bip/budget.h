@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_BUDGET
+#define H_BUDGET
+
+#include "utils.h"
+#include "matrix.h"
+
+/* Most nodes a search evaluates between two checks of the limits */
+#define BUDGET_PERIOD 256
+
+/* Seconds between two checks of the limits the searches aim for */
+#define BUDGET_TICK 0.01
+
+/* Seconds between two reports of the progress if none are given */
+#define BUDGET_INTERVAL 0.5
+
+/* Limit that stopped a search */
+enum SearchStop {
+    stop_none,          /* Every open node was explored */
+    stop_nodes,
+    stop_time,
+    stop_memory,
+    stop_cancel         /* The caller asked for it */
+};
+
+/* State of a resolution in progress */
+typedef struct {
+    long nodes;         /* Evaluated so far */
+    double seconds;     /* Since the resolution started */
+    double rate;        /* Nodes per second since the last report */
+    int depth;          /* Variables fixed where the reporting search is */
+    bool found;         /* A solution was found */
+    number alpha;       /* Its performance */
+    bool bounded;       /* The bound is known, not in parallel searches */
+    number bound;       /* Best performance any solution can have */
+} search_progress;
+
+/* Called with the progress of a resolution and the data given with it */
+typedef void (*progress_hook)(search_progress* p, void* data);
+
+/**
+ * Limits of a resolution, shared by every search of it.
+ *
+ * The searches report the nodes they evaluate and the memory they take, and
+ * check the limits every 'period' nodes (or fewer when the node limit is
+ * close), so a limit costs a counter per node and a clock read per period.
+ * The period is scaled at each check for the checks to come every
+ * BUDGET_TICK seconds, up to BUDGET_PERIOD nodes for fast searches and down
+ * to every node for slow ones, such as traced searches. Once a limit is hit
+ * every search stops at its next node and leaves the best fit of its open
+ * nodes, which bounds what wasn't explored.
+ *
+ * The caller can stop the searches too, with a flag they read at every
+ * node, and watch them with a hook the searches call from their threads at
+ * most once per interval.
+ */
+typedef struct {
+
+    long node_limit;            /* 0 for no limit */
+    double time_limit;
+    unsigned int memory_limit;
+
+    GTimer* timer;
+    int stop;                   /* enum SearchStop, atomic */
+    int period;                 /* Nodes between two checks, atomic */
+
+    int* cancel;                /* Not 0 to stop, atomic, NULL for none */
+    progress_hook hook;         /* NULL for none */
+    void* data;
+    double interval;
+    number offset;              /* Added to the performances reported */
+
+    /* Updated with the lock */
+    GMutex lock;
+    long nodes;
+    long memory;
+    long peak;                  /* Most memory taken at once */
+    double checked;             /* When the limits were last checked */
+    bool opened;                /* Some node was left open */
+    number open;                /* Best fit of the open nodes */
+    double reported;            /* When the progress was last reported */
+    long reported_nodes;
+
+} search_budget;
+
+/**
+ * Create the limits of a resolution and start its clock.
+ *
+ * @param nodes, the most nodes to evaluate, 0 for no limit.
+ * @param seconds, the most time to take, 0 for no limit.
+ * @param memory, the most bytes the searches can take, 0 for no limit.
+ * @return a pointer to the limits or NULL if enough memory could not be
+ *         allocated.
+ */
+search_budget* budget_new(long nodes, double seconds, unsigned int memory);
+
+/**
+ * Let the caller stop and watch the searches.
+ *
+ * @param b, the limits (by reference)
+ * @param cancel, a flag the caller sets to something other than 0 (with
+ *        g_atomic_int_set()) to stop the searches, NULL for none.
+ * @param hook, the function to report the progress to, NULL for none.
+ * @param data, passed to the hook as is.
+ * @param interval, the least seconds between two reports, 0 for
+ *        BUDGET_INTERVAL.
+ * @return nothing
+ */
+void budget_watch(search_budget* b, int* cancel, progress_hook hook,
+                  void* data, double interval);
+
+/**
+ * Check if a limit stopped the searches, or the caller did, without checking
+ * the limits.
+ *
+ * @param b, the limits (by reference), NULL for none.
+ * @return TRUE if the searches must stop.
+ */
+static inline bool budget_stopped(search_budget* b)
+{
+    if(b == NULL) {
+        return false;
+    }
+    if(g_atomic_int_get(&b->stop) != stop_none) {
+        return true;
+    }
+    if((b->cancel != NULL) && (g_atomic_int_get(b->cancel) != 0)) {
+        g_atomic_int_compare_and_exchange(&b->stop, stop_none, stop_cancel);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Count the nodes a search evaluated since it last did.
+ *
+ * @param b, the limits (by reference), NULL for none.
+ * @param nodes, the nodes evaluated.
+ * @return nothing
+ */
+void budget_count(search_budget* b, long nodes);
+
+/**
+ * Count the memory a search takes or frees.
+ *
+ * @param b, the limits (by reference), NULL for none.
+ * @param bytes, positive for memory taken, negative for memory freed.
+ * @return nothing
+ */
+void budget_reserve(search_budget* b, long bytes);
+
+/**
+ * Time since the resolution started.
+ *
+ * @param b, the limits (by reference), NULL for none.
+ * @return the seconds elapsed, 0 if there are no limits.
+ */
+double budget_elapsed(search_budget* b);
+
+/**
+ * Check the limits and the cancel flag, stopping the searches if one is hit.
+ *
+ * @param b, the limits (by reference), NULL for none.
+ * @return TRUE if the searches must stop.
+ */
+bool budget_check(search_budget* b);
+
+/**
+ * Nodes a search can evaluate before checking the limits again.
+ *
+ * @param b, the limits (by reference), NULL for none.
+ * @return the period, or fewer if the node limit is closer.
+ */
+long budget_period(search_budget* b);
+
+/**
+ * Check if the progress is due to be reported, and if so take the nodes,
+ * the time and the rate for the report. The searching thread fills the rest
+ * and calls budget_report().
+ *
+ * @param b, the limits (by reference), NULL for none.
+ * @param p, the progress to fill.
+ * @return TRUE if the progress is due, only for one of the searches.
+ */
+bool budget_due(search_budget* b, search_progress* p);
+
+/**
+ * Report the progress to the hook.
+ *
+ * @param b, the limits (by reference)
+ * @param p, the progress, with performances of the model searched. They are
+ *        moved by 'offset' to the ones of the model given.
+ * @return nothing
+ */
+void budget_report(search_budget* b, search_progress* p);
+
+/**
+ * Keep the best fit of a node left open by a stopped search.
+ *
+ * @param b, the limits (by reference)
+ * @param bf, the best fit of the node, a bound of its subtree.
+ * @param maximize, the direction of the optimization.
+ * @return nothing
+ */
+void budget_open(search_budget* b, number bf, bool maximize);
+
+/**
+ * Result of the searches once they are done.
+ *
+ * @param b, the limits (by reference), NULL for none.
+ * @param alpha, the performance of the best solution found.
+ * @param maximize, the direction of the optimization.
+ * @param bound, where to store the best of alpha and the best fit of the
+ *        open nodes, a bound of the optimum.
+ * @return the limit that stopped the searches, stop_none if no node was
+ *         left open, even if a limit was hit after the last one.
+ */
+enum SearchStop budget_result(search_budget* b, number alpha, bool maximize,
+                              number* bound);
+
+/**
+ * Free resources associated with the limits.
+ *
+ * @return nothing
+ * @param b, the limits (by reference)
+ */
+void budget_free(search_budget* b);
+
+#endif
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "cache.h"
+
+static uint64_t key_hash(trans_cache* t, assignment* fixed)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for(int w = 0; w < t->words; w++) {
+        hash = (hash ^ fixed->mask[w]) * 1099511628211ULL;
+    }
+    for(int i = 0; i < t->num_rest; i++) {
+        uint64_t bits = 0;
+        memcpy(&bits, &t->key[i], sizeof(number));
+        hash = (hash ^ bits) * 1099511628211ULL;
+    }
+    return hash ^ (hash >> 29);
+}
+
+static bool same_key(trans_cache* t, int e, assignment* fixed)
+{
+    return (memcmp(&t->mask[(size_t) e * t->words], fixed->mask,
+                   t->words * sizeof(uint64_t)) == 0) &&
+           (memcmp(&t->rhs[(size_t) e * t->num_rest], t->key,
+                   t->num_rest * sizeof(number)) == 0);
+}
+
+trans_cache* cache_new(bip_context* c)
+{
+    /* Allocate structure */
+    trans_cache* t = (trans_cache*) malloc(sizeof(trans_cache));
+    if(t == NULL) {
+        return NULL;
+    }
+    t->num_vars = c->num_vars;
+    t->num_rest = c->num_rest;
+    t->words = ASSIGNMENT_WORDS(c->num_vars);
+    t->eviction = c->eviction;
+    t->clock = 0;
+    t->hits = 0;
+
+    size_t entry = sizeof(char) + (2 * sizeof(long)) + sizeof(number) +
+                   ((2 * t->words + 1) * sizeof(uint64_t)) +
+                   (t->num_rest * sizeof(number));
+    size_t buckets = c->cache_memory / (CACHE_WAYS * entry);
+    if(buckets < 1) {
+        buckets = 1;
+    } else if(buckets > INT_MAX / (2 * CACHE_WAYS)) {
+        buckets = INT_MAX / (2 * CACHE_WAYS);
+    }
+    t->buckets = (int) buckets;
+
+    /* Try to allocate dynamic memory */
+    size_t entries = buckets * CACHE_WAYS;
+    t->kind     = (char*) calloc(entries, sizeof(char));
+    t->hash     = (uint64_t*) malloc(entries * sizeof(uint64_t));
+    t->mask     = (uint64_t*) malloc(entries * t->words * sizeof(uint64_t));
+    t->rhs      = (number*) malloc((entries * t->num_rest + 1) *
+                                   sizeof(number));
+    t->solution = (uint64_t*) malloc(entries * t->words * sizeof(uint64_t));
+    t->bound    = (number*) malloc(entries * sizeof(number));
+    t->work     = (long*) malloc(entries * sizeof(long));
+    t->used     = (long*) malloc(entries * sizeof(long));
+    t->key      = (number*) malloc((t->num_rest + 1) * sizeof(number));
+    if((t->kind == NULL) || (t->hash == NULL) || (t->mask == NULL) ||
+       (t->rhs == NULL) || (t->solution == NULL) || (t->bound == NULL) ||
+       (t->work == NULL) || (t->used == NULL) || (t->key == NULL)) {
+        cache_free(t);
+        return NULL;
+    }
+    return t;
+}
+
+int cache_find(trans_cache* t, assignment* fixed)
+{
+    uint64_t hash = key_hash(t, fixed);
+    int first = (int) (hash % t->buckets) * CACHE_WAYS;
+    for(int e = first; e < first + CACHE_WAYS; e++) {
+        if((t->kind[e] != cache_unused) && (t->hash[e] == hash) &&
+           same_key(t, e, fixed)) {
+            t->used[e] = t->clock++;
+            t->hits++;
+            return e;
+        }
+    }
+    return -1;
+}
+
+void cache_store(trans_cache* t, assignment* fixed, enum CacheKind kind,
+                 number bound, assignment* solution, long work)
+{
+    uint64_t hash = key_hash(t, fixed);
+    int first = (int) (hash % t->buckets) * CACHE_WAYS;
+
+    /* The entry of the node, a free one or the victim */
+    int e = -1;
+    int victim = first;
+    for(int k = first; (k < first + CACHE_WAYS) && (e == -1); k++) {
+        if((t->kind[k] == cache_unused) ||
+           ((t->hash[k] == hash) && same_key(t, k, fixed))) {
+            e = k;
+        } else if(t->eviction == evict_oldest) {
+            if(t->used[k] < t->used[victim]) {
+                victim = k;
+            }
+        } else if(t->work[k] < t->work[victim]) {
+            victim = k;
+        }
+    }
+    if(e == -1) {
+        e = victim;
+    }
+
+    t->kind[e] = (char) kind;
+    t->hash[e] = hash;
+    memcpy(&t->mask[(size_t) e * t->words], fixed->mask,
+           t->words * sizeof(uint64_t));
+    memcpy(&t->rhs[(size_t) e * t->num_rest], t->key,
+           t->num_rest * sizeof(number));
+    if(solution != NULL) {
+        memcpy(&t->solution[(size_t) e * t->words], solution->value,
+               t->words * sizeof(uint64_t));
+    }
+    t->bound[e] = bound;
+    t->work[e] = work;
+    t->used[e] = t->clock++;
+}
+
+void cache_restore(trans_cache* t, int entry, assignment* fixed,
+                   assignment* vars)
+{
+    uint64_t* solution = &t->solution[(size_t) entry * t->words];
+    for(int w = 0; w < t->words; w++) {
+        vars->mask[w] = ~((uint64_t) 0);
+        vars->value[w] = fixed->value[w] | (solution[w] & ~fixed->mask[w]);
+    }
+
+    /* Keep the bits past the last variable clear */
+    int tail = t->num_vars % ASSIGNMENT_BITS;
+    if(tail != 0) {
+        uint64_t last = ((uint64_t) 1 << tail) - 1;
+        vars->mask[t->words - 1] &= last;
+        vars->value[t->words - 1] &= last;
+    }
+}
+
+unsigned int cache_sizeof(trans_cache* t)
+{
+    if(t == NULL) {
+        return 0;
+    }
+    size_t entries = (size_t) t->buckets * CACHE_WAYS;
+    size_t entry = sizeof(char) + (2 * sizeof(long)) + sizeof(number) +
+                   ((2 * t->words + 1) * sizeof(uint64_t)) +
+                   (t->num_rest * sizeof(number));
+    return sizeof(trans_cache) + (entries * entry) +
+           ((t->num_rest + 1) * sizeof(number));
+}
+
+void cache_free(trans_cache* t)
+{
+    if(t == NULL) {
+        return;
+    }
+    free(t->kind);
+    free(t->hash);
+    free(t->mask);
+    free(t->rhs);
+    free(t->solution);
+    free(t->bound);
+    free(t->work);
+    free(t->used);
+    free(t->key);
+    free(t);
+}
@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef H_CACHE
+#define H_CACHE
+
+#include "bip.h"
+#include "assignment.h"
+
+/* Default memory for the transposition cache, 64 MiB */
+#define CACHE_MEMORY 67108864
+
+/* Entries of each bucket, a new entry goes to the bucket of its hash */
+#define CACHE_WAYS 4
+
+/* What is known of the subtree of an entry */
+enum CacheKind {
+    cache_unused,       /* Nothing, the entry is not used */
+    cache_empty,        /* No completion is factible */
+    cache_bound,        /* No completion performs better than 'bound' */
+    cache_exact         /* The best completion performs 'bound', and it is
+                         * kept in 'solution' */
+};
+
+/**
+ * Transposition cache of explored subtrees.
+ *
+ * Two nodes with the same free variables and the same residual right hand
+ * side of every restriction (its equality minus the activity of the fixed
+ * variables) root the same subproblem, whatever values took them there. Once
+ * the subtree of a node is explored the cache keeps what was learnt of it,
+ * relative to the performance of the fixed variables, so a node reached
+ * later through another path is closed or solved at once. A residual right
+ * hand side that leaves a restriction redundant for every completion is
+ * clamped to the one that just does, so restrictions no longer binding
+ * don't tell nodes apart.
+ *
+ * Entries are kept whole, the mask of the free variables and the residual
+ * of every restriction, and compared in full on a hash match, so a node
+ * takes 2 * ceil(num_vars / 64) words and num_rest coefficients plus its
+ * entry. The buckets are sized to 'cache_memory' bytes, a full bucket drops
+ * the entry the 'eviction' policy of the context picks.
+ */
+typedef struct {
+
+    int num_vars;
+    int num_rest;
+    int words;
+    int buckets;
+    enum CacheEviction eviction;
+
+    /* CACHE_WAYS entries per bucket */
+    char* kind;
+    uint64_t* hash;
+    uint64_t* mask;     /* 'words' words per entry */
+    number* rhs;        /* 'num_rest' per entry */
+    uint64_t* solution; /* 'words' words per entry */
+    number* bound;      /* Relative to the fixed variables */
+    long* work;         /* Nodes its subtree took */
+    long* used;         /* Last time it was stored or found */
+
+    /* Residual of the node being looked up or stored */
+    number* key;
+    long clock;
+    long hits;
+
+} trans_cache;
+
+/**
+ * Create an empty transposition cache.
+ *
+ * @param c, the binary integer programming context data structure.
+ * @return a pointer to the cache or NULL if enough memory could not be
+ *         allocated. It has at least one bucket.
+ */
+trans_cache* cache_new(bip_context* c);
+
+/**
+ * Find the entry of a node, whose residual is in 'key'.
+ *
+ * @param t, the cache (by reference)
+ * @param fixed, the fixed variables of the node.
+ * @return the index of the entry, -1 if there is none.
+ */
+int cache_find(trans_cache* t, assignment* fixed);
+
+/**
+ * Keep what is known of the explored subtree of a node, whose residual is in
+ * 'key'. The entry of the same node is replaced, if there is none a free one
+ * of its bucket is taken or else the one the eviction policy picks.
+ *
+ * @param t, the cache (by reference)
+ * @param fixed, the fixed variables of the node.
+ * @param kind, what is known of the subtree.
+ * @param bound, the performance of the free variables.
+ * @param solution, the best solution of the subtree if exact, NULL if not.
+ * @param work, the nodes the subtree took.
+ * @return nothing
+ */
+void cache_store(trans_cache* t, assignment* fixed, enum CacheKind kind,
+                 number bound, assignment* solution, long work);
+
+/**
+ * Complete the fixed variables of a node with the free ones of the solution
+ * of an exact entry.
+ *
+ * @param t, the cache (by reference)
+ * @param entry, the index of the entry.
+ * @param fixed, the fixed variables of the node.
+ * @param vars, the destination assignment, left with all variables fixed.
+ * @return nothing
+ */
+void cache_restore(trans_cache* t, int entry, assignment* fixed,
+                   assignment* vars);
+
+/**
+ * Calculates the memory required by the cache.
+ *
+ * @return the size of the cache in bytes.
+ * @param t, the cache (by reference)
+ */
+unsigned int cache_sizeof(trans_cache* t);
+
+/**
+ * Free resources associated with a transposition cache.
+ *
+ * @return nothing
+ * @param t, the cache (by reference)
+ */
+void cache_free(trans_cache* t);
+
+#endif
@@ -0,0 +1,677 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "cuts.h"
+#include "lp.h"
+#include "assignment.h"
+
+/* Inequality sum value * x <= equl, by increasing column */
+typedef struct {
+    int size;
+    int* column;
+    number* value;
+    number equl;
+    int age;    /* Rounds it has been slack */
+    int row;    /* Restriction in the last relaxation, -1 if new */
+} cut;
+
+typedef struct {
+    int column;
+    number value;
+} term;
+
+typedef struct {
+    double key;
+    int k;
+} ranked;
+
+/* Restriction as a knapsack sum weight * y <= rhs, with y = 1 - x for the
+ * complemented variables so every weight is positive */
+typedef struct {
+    int len;
+    int* column;
+    number* weight;
+    bool* comp;
+    double* y;      /* In the solution of the relaxation */
+    number rhs;
+} knapsack;
+
+typedef struct {
+    bip_context* c;
+    sparse* rows;
+    bool own_rows;
+
+    /* Pool */
+    cut* pool;
+    int size;
+    int limit;      /* Cuts that keep the relaxation usable */
+    int added;      /* In this round */
+
+    /* Last relaxation and the restriction of the next one for each of its
+     * restrictions */
+    lp* relax;
+    int* map;
+
+    double* x;      /* Solution of the relaxation */
+    assignment* fixed;
+    uint64_t* graph;    /* Conflicts between literals, 2 * var + value */
+
+    /* Scratch */
+    knapsack k;
+    ranked* order;
+    term* terms;
+    bool* in;
+    int* clique;
+} separator;
+
+static int by_key(const void* x, const void* y)
+{
+    const ranked* p = (const ranked*) x;
+    const ranked* q = (const ranked*) y;
+    if(p->key != q->key) {
+        return (p->key < q->key) ? -1 : 1;
+    }
+    return p->k - q->k;
+}
+
+static int by_column(const void* x, const void* y)
+{
+    return ((const term*) x)->column - ((const term*) y)->column;
+}
+
+static double lhs(separator* p, int* column, number* value, int size)
+{
+    double sum = 0.0;
+    for(int k = 0; k < size; k++) {
+        sum += value[k] * p->x[column[k]];
+    }
+    return sum;
+}
+
+/* Value of a literal in the relaxation */
+static double literal(separator* p, int lit)
+{
+    double x = p->x[lit / 2];
+    return (lit % 2 == 1) ? x : 1.0 - x;
+}
+
+static void conflict(separator* p, int l1, int l2)
+{
+    int lits = 2 * p->c->num_vars;
+    size_t b1 = ((size_t) l1 * lits) + l2;
+    size_t b2 = ((size_t) l2 * lits) + l1;
+    p->graph[b1 / 64] |= (uint64_t) 1 << (b1 % 64);
+    p->graph[b2 / 64] |= (uint64_t) 1 << (b2 % 64);
+}
+
+static bool adjacent(separator* p, int l1, int l2)
+{
+    size_t b = ((size_t) l1 * 2 * p->c->num_vars) + l2;
+    return (p->graph[b / 64] >> (b % 64)) & 1;
+}
+
+/* Read restriction i, negated if sign is -1, as a knapsack. FALSE if it is
+ * empty or not even the relaxation can satisfy it. */
+static bool load(separator* p, int i, int sign)
+{
+    sparse* s = p->rows;
+    knapsack* k = &p->k;
+    k->len = 0;
+    k->rhs = sign * rest_equl(p->c, i);
+    for(int t = s->row_start[i]; t < s->row_start[i + 1]; t++) {
+        int j = s->row_column[t];
+        number coeff = sign * s->row_value[t];
+        if(coeff == 0) {
+            continue;
+        }
+        k->column[k->len] = j;
+        k->weight[k->len] = (coeff < 0) ? -coeff : coeff;
+        k->comp[k->len] = (coeff < 0);
+        k->y[k->len] = (coeff < 0) ? 1.0 - p->x[j] : p->x[j];
+        if(coeff < 0) {
+            k->rhs -= coeff;
+        }
+        k->len++;
+    }
+    return (k->len > 0) && (k->rhs >= 0);
+}
+
+/* Literal of the knapsack item t being 1 */
+static int item(knapsack* k, int t)
+{
+    return (2 * k->column[t]) + (k->comp[t] ? 0 : 1);
+}
+
+/* Keep sum terms <= equl if the relaxation violates it enough and it is not
+ * in the pool already */
+static void offer(separator* p, term* terms, int size, number equl)
+{
+    if((p->size == p->limit) || (p->added == CUTS_PER_ROUND)) {
+        return;
+    }
+
+    /* Drop zeros and check the violation */
+    int kept = 0;
+    double sum = 0.0;
+    for(int t = 0; t < size; t++) {
+        if(terms[t].value != 0) {
+            sum += terms[t].value * p->x[terms[t].column];
+            terms[kept++] = terms[t];
+        }
+    }
+    if((kept == 0) || (sum - equl <= CUTS_VIOLATION)) {
+        return;
+    }
+    qsort(terms, kept, sizeof(term), by_column);
+
+    for(int q = 0; q < p->size; q++) {
+        cut* o = &p->pool[q];
+        bool same = (o->size == kept) && (o->equl == equl);
+        for(int t = 0; same && (t < kept); t++) {
+            same = (o->column[t] == terms[t].column) &&
+                   (o->value[t] == terms[t].value);
+        }
+        if(same) {
+            return;
+        }
+    }
+
+    cut* n = &p->pool[p->size];
+    n->column = (int*) malloc(kept * sizeof(int));
+    n->value = (number*) malloc(kept * sizeof(number));
+    if((n->column == NULL) || (n->value == NULL)) {
+        free(n->column);
+        free(n->value);
+        return;
+    }
+    for(int t = 0; t < kept; t++) {
+        n->column[t] = terms[t].column;
+        n->value[t] = terms[t].value;
+    }
+    n->size = kept;
+    n->equl = equl;
+    n->age = 0;
+    n->row = -1;
+    p->size++;
+    p->added++;
+}
+
+/* Extended cover of the knapsack loaded */
+static void cover(separator* p)
+{
+    knapsack* k = &p->k;
+
+    /* Fewest missing from 1 per unit of weight first */
+    number total = 0;
+    for(int t = 0; t < k->len; t++) {
+        p->order[t].key = (1.0 - k->y[t]) / k->weight[t];
+        p->order[t].k = t;
+        p->in[t] = false;
+        total += k->weight[t];
+    }
+    if(total <= k->rhs) {
+        return;
+    }
+    qsort(p->order, k->len, sizeof(ranked), by_key);
+
+    number weight = 0;
+    for(int r = 0; weight <= k->rhs; r++) {
+        int t = p->order[r].k;
+        p->in[t] = true;
+        weight += k->weight[t];
+    }
+
+    /* Minimal, dropping the smallest values first */
+    for(int t = 0; t < k->len; t++) {
+        p->order[t].key = k->y[t];
+        p->order[t].k = t;
+    }
+    qsort(p->order, k->len, sizeof(ranked), by_key);
+    int count = 0;
+    number heaviest = 0;
+    for(int r = 0; r < k->len; r++) {
+        int t = p->order[r].k;
+        if(!p->in[t]) {
+            continue;
+        }
+        if(weight - k->weight[t] > k->rhs) {
+            p->in[t] = false;
+            weight -= k->weight[t];
+        } else {
+            count++;
+            if(k->weight[t] > heaviest) {
+                heaviest = k->weight[t];
+            }
+        }
+    }
+
+    /* Extend and go back to x */
+    number equl = count - 1;
+    for(int t = 0; t < k->len; t++) {
+        bool use = p->in[t] || (k->weight[t] >= heaviest);
+        p->terms[t].column = k->column[t];
+        p->terms[t].value = use ? (k->comp[t] ? -1 : 1) : 0;
+        if(use && k->comp[t]) {
+            equl--;
+        }
+    }
+    offer(p, p->terms, k->len, equl);
+}
+
+/* Quotient of a weight or right hand side, rounded down */
+static number quotient(number w, number d)
+{
+#if defined(COEFF_DOUBLE)
+    return floor(w / d);
+#else
+    return w / d;
+#endif
+}
+
+/* Chvatal-Gomory rounding of the knapsack loaded */
+static void rounding(separator* p)
+{
+    knapsack* k = &p->k;
+
+    /* Divisors, the weights of the fractional items */
+    number divisors[CUTS_DIVISORS];
+    int found = 0;
+    for(int t = 0; (t < k->len) && (found < CUTS_DIVISORS); t++) {
+        number d = k->weight[t];
+        bool fractional = (k->y[t] > LP_FEASIBLE) &&
+                          (k->y[t] < 1.0 - LP_FEASIBLE);
+        bool seen = false;
+        for(int f = 0; f < found; f++) {
+            seen = seen || (divisors[f] == d);
+        }
+        if(fractional && (d > 1) && !seen) {
+            divisors[found++] = d;
+        }
+    }
+
+    for(int f = 0; f < found; f++) {
+        number d = divisors[f];
+        number equl = quotient(k->rhs, d);
+        for(int t = 0; t < k->len; t++) {
+            number q = quotient(k->weight[t], d);
+            p->terms[t].column = k->column[t];
+            p->terms[t].value = k->comp[t] ? -q : q;
+            if(k->comp[t]) {
+                equl -= q;
+            }
+        }
+        offer(p, p->terms, k->len, equl);
+    }
+}
+
+/* Conflicts of the pairs of items that don't fit together */
+static void build_graph(separator* p)
+{
+    knapsack* k = &p->k;
+    for(int i = 0; i < p->c->num_rest; i++) {
+        int type = rest_type(p->c, i);
+        for(int sign = 1; sign >= -1; sign -= 2) {
+            if((type == ((sign == 1) ? GE : LE)) || !load(p, i, sign)) {
+                continue;
+            }
+            for(int t = 0; t < k->len; t++) {
+                p->order[t].key = -k->weight[t];
+                p->order[t].k = t;
+            }
+            qsort(p->order, k->len, sizeof(ranked), by_key);
+
+            /* By decreasing weight, so the partners of each item are a
+             * prefix */
+            for(int a = 0; a < k->len; a++) {
+                int ta = p->order[a].k;
+                for(int b = a + 1; b < k->len; b++) {
+                    int tb = p->order[b].k;
+                    if(k->weight[ta] + k->weight[tb] <= k->rhs) {
+                        break;
+                    }
+                    conflict(p, item(k, ta), item(k, tb));
+                }
+            }
+        }
+    }
+}
+
+/* Cliques of the conflict graph grown from the largest literals */
+static void cliques(separator* p)
+{
+    int lits = 2 * p->c->num_vars;
+    int candidates = 0;
+    for(int l = 0; l < lits; l++) {
+        double v = literal(p, l);
+        if(v > LP_FEASIBLE) {
+            p->order[candidates].key = -v;
+            p->order[candidates].k = l;
+            candidates++;
+        }
+    }
+    qsort(p->order, candidates, sizeof(ranked), by_key);
+
+    for(int s = 0; (s < candidates) && (s < CUTS_SEEDS); s++) {
+        int size = 0;
+        double sum = 0.0;
+        p->clique[size++] = p->order[s].k;
+        sum += literal(p, p->order[s].k);
+
+        for(int r = 0; r < candidates; r++) {
+            int l = p->order[r].k;
+            bool all = (r != s);
+            for(int q = 0; all && (q < size); q++) {
+                all = adjacent(p, l, p->clique[q]);
+            }
+            if(all) {
+                p->clique[size++] = l;
+                sum += literal(p, l);
+            }
+        }
+        if(sum <= 1.0 + CUTS_VIOLATION) {
+            continue;
+        }
+
+        /* Maximal, with the literals at 0 */
+        for(int l = 0; l < lits; l++) {
+            bool all = (literal(p, l) <= LP_FEASIBLE);
+            for(int q = 0; all && (q < size); q++) {
+                all = adjacent(p, l, p->clique[q]);
+            }
+            if(all) {
+                p->clique[size++] = l;
+            }
+        }
+
+        number equl = 1;
+        for(int q = 0; q < size; q++) {
+            int l = p->clique[q];
+            p->terms[q].column = l / 2;
+            p->terms[q].value = (l % 2 == 1) ? 1 : -1;
+            if(l % 2 == 0) {
+                equl--;
+            }
+        }
+        offer(p, p->terms, size, equl);
+    }
+}
+
+/* Age the cuts slack in the relaxation, dropping the old ones */
+static void age(separator* p, int most)
+{
+    int kept = 0;
+    for(int q = 0; q < p->size; q++) {
+        cut* o = &p->pool[q];
+        double slack = o->equl - lhs(p, o->column, o->value, o->size);
+        o->age = (slack > LP_FEASIBLE) ? o->age + 1 : 0;
+        if(o->age > most) {
+            free(o->column);
+            free(o->value);
+        } else {
+            p->pool[kept++] = *o;
+        }
+    }
+    p->size = kept;
+}
+
+/* The model followed by the cuts in the pool */
+static bip_context* strengthen(separator* p)
+{
+    bip_context* c = p->c;
+    sparse* s = p->rows;
+    int n = c->num_vars;
+    int m = c->num_rest;
+    int rests = m + p->size;
+
+    int nnz = s->nnz;
+    for(int q = 0; q < p->size; q++) {
+        nnz += p->pool[q].size;
+    }
+
+    /* Try to allocate memory */
+    int* starts  = (int*) malloc((rests + 1) * sizeof(int));
+    int* columns = (int*) malloc((nnz + 1) * sizeof(int));
+    number* values = (number*) malloc((nnz + 1) * sizeof(number));
+    int* types     = (int*) malloc((rests + 1) * sizeof(int));
+    number* equls  = (number*) malloc((rests + 1) * sizeof(number));
+    bip_context* r = NULL;
+    if((starts != NULL) && (columns != NULL) && (values != NULL) &&
+       (types != NULL) && (equls != NULL)) {
+
+        memcpy(starts, s->row_start, (m + 1) * sizeof(int));
+        memcpy(columns, s->row_column, s->nnz * sizeof(int));
+        memcpy(values, s->row_value, s->nnz * sizeof(number));
+        for(int i = 0; i < m; i++) {
+            types[i] = rest_type(c, i);
+            equls[i] = rest_equl(c, i);
+        }
+        int k = s->nnz;
+        for(int q = 0; q < p->size; q++) {
+            cut* o = &p->pool[q];
+            memcpy(columns + k, o->column, o->size * sizeof(int));
+            memcpy(values + k, o->value, o->size * sizeof(number));
+            k += o->size;
+            starts[m + q + 1] = k;
+            types[m + q] = LE;
+            equls[m + q] = o->equl;
+        }
+
+        r = bip_context_from_rows(n, rests, starts, columns, values, types,
+                                  equls);
+        if(r != NULL) {
+            r->maximize = c->maximize;
+            memcpy(r->function, c->function, n * sizeof(number));
+        }
+    }
+
+    free(starts);
+    free(columns);
+    free(values);
+    free(types);
+    free(equls);
+    return r;
+}
+
+/* Relaxation of the model with the cuts in the pool, warm started from the
+ * last one. NULL if it doesn't fit. */
+static lp* relax(separator* p)
+{
+    bip_context* s = strengthen(p);
+    if(s == NULL) {
+        return NULL;
+    }
+    lp* l = lp_new(s);
+    bip_context_free(s);
+
+    int m = p->c->num_rest;
+    if((l != NULL) && (p->relax != NULL)) {
+        for(int i = 0; i < p->relax->num_rest; i++) {
+            p->map[i] = (i < m) ? i : -1;
+        }
+        for(int q = 0; q < p->size; q++) {
+            if(p->pool[q].row != -1) {
+                p->map[p->pool[q].row] = m + q;
+            }
+        }
+        lp_warm(l, p->relax, p->map);
+    }
+    for(int q = 0; q < p->size; q++) {
+        p->pool[q].row = m + q;
+    }
+
+    lp_free(p->relax);
+    p->relax = l;
+    return l;
+}
+
+static void separator_free(separator* p)
+{
+    for(int q = 0; q < p->size; q++) {
+        free(p->pool[q].column);
+        free(p->pool[q].value);
+    }
+    if(p->own_rows) {
+        sparse_free(p->rows);
+    }
+    free(p->pool);
+    lp_free(p->relax);
+    free(p->map);
+    free(p->x);
+    assignment_free(p->fixed);
+    free(p->graph);
+    free(p->k.column);
+    free(p->k.weight);
+    free(p->k.comp);
+    free(p->k.y);
+    free(p->order);
+    free(p->terms);
+    free(p->in);
+    free(p->clique);
+}
+
+static bool separator_init(separator* p, bip_context* c)
+{
+    int n = c->num_vars;
+    int m = c->num_rest;
+
+    p->c = c;
+    p->size = 0;
+    p->added = 0;
+    p->relax = NULL;
+
+    /* Walk the restrictions by rows, index the dense ones if needed */
+    p->rows = c->sparse_rests;
+    p->own_rows = false;
+    if(p->rows == NULL) {
+        p->rows = sparse_from_matrix(c->restrictions, n);
+        p->own_rows = true;
+    }
+
+    /* At most as many cuts as restrictions, each round solves the
+     * relaxation from scratch. The relaxation must still fit. */
+    p->limit = (m < CUTS_PER_ROUND) ? CUTS_PER_ROUND : m;
+    if(p->limit > CUTS_POOL) {
+        p->limit = CUTS_POOL;
+    }
+    while((p->limit > 0) && (2.0 * (m + p->limit) * (n + m + p->limit + 1) >
+                             LP_MAX_CELLS)) {
+        p->limit /= 2;
+    }
+
+    /* The conflict graph only if it fits */
+    double bits = 4.0 * n * n;
+    p->graph = NULL;
+    if(bits <= CUTS_GRAPH_BITS) {
+        p->graph = (uint64_t*) calloc(((size_t) bits / 64) + 1,
+                                      sizeof(uint64_t));
+    }
+
+    /* Try to allocate dynamic memory */
+    p->pool     = (cut*) malloc((p->limit + 1) * sizeof(cut));
+    p->map      = (int*) malloc((m + p->limit + 1) * sizeof(int));
+    p->x        = (double*) calloc(n, sizeof(double));
+    p->fixed    = assignment_new(n);
+    p->k.column = (int*) malloc(n * sizeof(int));
+    p->k.weight = (number*) malloc(n * sizeof(number));
+    p->k.comp   = (bool*) malloc(n * sizeof(bool));
+    p->k.y      = (double*) malloc(n * sizeof(double));
+    p->order    = (ranked*) malloc(2 * n * sizeof(ranked));
+    p->terms    = (term*) malloc(2 * n * sizeof(term));
+    p->in       = (bool*) malloc(2 * n * sizeof(bool));
+    p->clique   = (int*) malloc(2 * n * sizeof(int));
+    if((p->rows == NULL) || (p->pool == NULL) || (p->map == NULL) ||
+       (p->x == NULL) || (p->fixed == NULL) || (p->k.column == NULL) ||
+       (p->k.weight == NULL) || (p->k.comp == NULL) || (p->k.y == NULL) ||
+       (p->order == NULL) || (p->terms == NULL) || (p->in == NULL) ||
+       (p->clique == NULL) || ((bits <= CUTS_GRAPH_BITS) &&
+                               (p->graph == NULL))) {
+        separator_free(p);
+        return false;
+    }
+    return true;
+}
+
+bip_context* cuts_separate(bip_context* c)
+{
+    if(c->num_rest == 0) {
+        return NULL;
+    }
+
+    separator p;
+    if(!separator_init(&p, c)) {
+        return NULL;
+    }
+    if(p.graph != NULL) {
+        build_graph(&p);
+    }
+
+    double last = 0.0;
+    int rounds = 0;
+    while(p.limit > 0) {
+
+        /* Optimum of the relaxation with the cuts so far */
+        lp* l = relax(&p);
+        double z = 0.0;
+        bool factible = (l != NULL);
+        for(int s = 0; factible && (s < CUTS_SOLVES); s++) {
+            factible = lp_bound(l, p.fixed, &z);
+            if(l->optimal) {
+                break;
+            }
+        }
+        if(!factible || !l->optimal) {
+            break;
+        }
+        lp_values(l, p.x);
+
+        age(&p, CUTS_AGE);
+        if((rounds == CUTS_ROUNDS) || ((rounds > 0) &&
+           (fabs(z - last) <= CUTS_STALL * (1.0 + fabs(z))))) {
+            break;
+        }
+        last = z;
+
+        /* Separate its solution */
+        p.added = 0;
+        for(int i = 0; i < c->num_rest; i++) {
+            int type = rest_type(c, i);
+            if((type != GE) && load(&p, i, 1)) {
+                cover(&p);
+                rounding(&p);
+            }
+            if((type != LE) && load(&p, i, -1)) {
+                cover(&p);
+                rounding(&p);
+            }
+        }
+        if(p.graph != NULL) {
+            cliques(&p);
+        }
+        rounds++;
+        if(p.added == 0) {
+            break;
+        }
+    }
+
+    /* Only the cuts the last relaxation needs */
+    age(&p, 0);
+    DEBUG("Cuts: %i added to the model after %i rounds.\n", p.size, rounds);
+
+    bip_context* r = (p.size > 0) ? strengthen(&p) : NULL;
+    separator_free(&p);
+    return r;
+}
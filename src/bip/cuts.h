@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef H_CUTS
+#define H_CUTS
+
+#include "bip.h"
+
+/* Rounds of separation, each solving the relaxation with the cuts so far,
+ * and calls to the simplex allowed to solve it */
+#define CUTS_ROUNDS 10
+#define CUTS_SOLVES 10
+
+/* Cuts kept in the pool, never more than restrictions unless fewer than a
+ * round adds, and added in a single round */
+#define CUTS_POOL 500
+#define CUTS_PER_ROUND 50
+
+/* Rounds a cut can be slack in the relaxation before it is dropped */
+#define CUTS_AGE 2
+
+/* Violation for a cut to be added, and change of the bound to go on */
+#define CUTS_VIOLATION 0.01
+#define CUTS_STALL 0.001
+
+/* Divisors tried by the rounding cuts and cliques grown per round */
+#define CUTS_DIVISORS 8
+#define CUTS_SEEDS 100
+
+/* Models whose conflict graph takes more bits than this get no cliques */
+#define CUTS_GRAPH_BITS 67108864
+
+/**
+ * Strengthen a model with cuts separated at the root, valid inequalities
+ * that every binary solution satisfies but the LP relaxation violates.
+ *
+ * Each round solves the relaxation of the model plus the cuts in the pool
+ * and separates its solution with:
+ *
+ *     Cover cuts     Each inequality is read as a knapsack, complementing
+ *                    the variables with negative coefficient. A cover, a
+ *                    set of variables that can't all be 1, is chosen
+ *                    greedily, made minimal and extended with the variables
+ *                    of weight not less than any in it.
+ *     Clique cuts    A conflict graph links two literals when a knapsack
+ *                    can't have both, at most one of a clique holds. Cliques
+ *                    are grown from the literals with the largest values and
+ *                    then made maximal.
+ *     Rounding cuts  Chvatal-Gomory rounding of a knapsack, dividing by one
+ *                    of its weights and rounding down.
+ *
+ * Rounds stop when nothing is found or the bound stalls. Cuts slack for more
+ * than CUTS_AGE rounds leave the pool, and only those tight at the last
+ * relaxation are added to the model, so they don't slow down the search
+ * beyond what they tighten. The pool at most doubles the restrictions and
+ * never makes the relaxation too big to be used, see LP_MAX_CELLS.
+ *
+ * @param c, the binary integer programming context data structure.
+ * @return a new context with the same variables and objective, and the
+ *         restrictions of the model followed by the cuts, or NULL if no cut
+ *         was kept or enough memory could not be allocated. Options are
+ *         left to the caller.
+ */
+bip_context* cuts_separate(bip_context* c);
+
+#endif
@@ -22,11 +22,28 @@
 #include "latex.h"
 #include "dialogs.h"
 #include "format.h"
+#include "probe.h"
 #include <gtk/gtk.h>
 
+/* Milliseconds between two pulses of the progress bar */
+#define PULSE_INTERVAL 100
+
 /* Context */
 bip_context* c = NULL;
 
+/* Resolution of the context, the search, the report and its conversion to
+ * PDF run on a worker so the window keeps responding meanwhile */
+typedef struct {
+    bip_context* c;
+    bool success;
+    bool report_created;
+    int as_pdf;
+} solve_job;
+
+GThreadPool* solver = NULL;
+bool solving = false;
+guint pulsing = 0;
+
 /* GUI */
 GtkWindow* window;
 GtkSpinButton* variables;
@@ -42,6 +59,10 @@ GtkTreeModel* types_model;
 GtkFileChooser* load_dialog;
 GtkFileChooser* save_dialog;
 
+GtkProgressBar* progress;
+GtkWidget* process_button;
+GtkWidget* cancel_button;
+
 /* Functions */
 /* Functions : Main */
 void clear_liststore(GtkTreeView* view);
@@ -82,6 +103,13 @@ void remove_row(GtkToolButton *toolbutton, gpointer user_data);
 
 /* Functions : Actions */
 void process(GtkButton* button, gpointer user_data);
+void cancel_cb(GtkButton* button, gpointer user_data);
+void solve(gpointer data, gpointer user_data);
+void solve_progress(search_progress* p, void* data);
+gboolean show_progress(gpointer data);
+gboolean show_stage(gpointer data);
+gboolean show_result(gpointer data);
+gboolean pulse(gpointer data);
 void save_cb(GtkButton* button, gpointer user_data);
 void load_cb(GtkButton* button, gpointer user_data);
 void save(FILE* file);
@@ -133,6 +161,10 @@ int main(int argc, char **argv)
     save_dialog = GTK_FILE_CHOOSER(
         gtk_builder_get_object(builder, "save_dialog"));
 
+    progress = GTK_PROGRESS_BAR(gtk_builder_get_object(builder, "progress"));
+    process_button = GTK_WIDGET(gtk_builder_get_object(builder, "process"));
+    cancel_button = GTK_WIDGET(gtk_builder_get_object(builder, "cancel"));
+
     /* Configure interface */
     GtkFileFilter* file_filter = gtk_file_filter_new();
     gtk_file_filter_set_name(file_filter, "Custom data file (*.bip)");
@@ -721,7 +753,7 @@ void process(GtkButton* button, gpointer user_data)
 
     /* Restriction coefficients */
     bool iter_set = gtk_tree_model_get_iter_first(restrictions, &iter);
-    for(int i = 0; iter_set && (i < num_vars); i++) {
+    for(int i = 0; iter_set && (i < num_rest); i++) {
         for(int j = 0; j < num_vars + 2; j++) {
             gtk_tree_model_get_value(restrictions, &iter, j, &gval);
             int val = g_value_get_int(&gval);
@@ -730,32 +762,173 @@ void process(GtkButton* button, gpointer user_data)
         }
         iter_set = gtk_tree_model_iter_next(restrictions, &iter);
     }
+    bip_context_sparsify(c);
+    c->progress = solve_progress;
 
-    /* Execute algorithm */
-    bool success = implicit_enumeration(c);
-    if(!success) {
-        show_error(window, "Error while processing the information.\n"
-                           "Please check your data.");
+    /* Hand the context to the worker, it isn't touched here until done */
+    solve_job* job = (solve_job*) malloc(sizeof(solve_job));
+    if(job == NULL) {
+        show_error(window, "Unable to allocate enough memory for "
+                           "this problem. Sorry.");
+        return;
+    }
+    job->c = c;
+    job->success = false;
+    job->report_created = false;
+    job->as_pdf = 0;
+
+    if(solver == NULL) {
+        solver = g_thread_pool_new(solve, NULL, 1, false, NULL);
+    }
+    if((solver == NULL) || !g_thread_pool_push(solver, job, NULL)) {
+        show_error(window, "Unable to start processing the information. "
+                           "Sorry.");
+        free(job);
+        return;
+    }
+
+    /* Only one resolution at a time, the model can be edited meanwhile */
+    solving = true;
+    gtk_widget_set_sensitive(process_button, false);
+    gtk_widget_set_sensitive(cancel_button, true);
+    gtk_progress_bar_set_text(progress, "Solving...");
+    gtk_widget_show(GTK_WIDGET(progress));
+
+    /* A pulse of the previous resolution may not have noticed it ended */
+    if(pulsing == 0) {
+        pulsing = g_timeout_add(PULSE_INTERVAL, pulse, NULL);
+    }
+}
+
+void cancel_cb(GtkButton* button, gpointer user_data)
+{
+    /* The search stops at its next check, the report is still created */
+    if(solving) {
+        bip_cancel(c);
+        gtk_widget_set_sensitive(cancel_button, false);
+    }
+}
+
+void solve(gpointer data, gpointer user_data)
+{
+    solve_job* job = (solve_job*) data;
+
+    /* Execute algorithm, tracing it in builds with probes */
+    probe_reset();
+    job->success = implicit_enumeration(job->c);
+    if(probe_export("reports/probes.json")) {
+        DEBUG("Probes written to reports/probes.json\n");
     }
 
     /* Generate report */
-    bool report_created = implicit_report(c);
-    if(!report_created) {
-        show_error(window, "Report could not be created.\n"
-                           "Please check your data.");
-    } else {
+    g_idle_add(show_stage, "Creating the report...");
+    job->report_created = implicit_report(job->c);
+    if(job->report_created) {
         DEBUG("Report created at reports/implicit.tex\n");
 
-        int as_pdf = latex2pdf("implicit", "reports");
-        if(as_pdf == 0) {
-            DEBUG("PDF version available at reports/implicit.pdf\n");
+        g_idle_add(show_stage, "Converting the report to PDF...");
+        job->as_pdf = latex2pdf("implicit", "reports");
+    }
+
+    /* Back to the main loop */
+    g_idle_add(show_result, job);
+}
+
+void solve_progress(search_progress* p, void* data)
+{
+    /* Called from the searching threads, the copy is shown by the main loop */
+    search_progress* copy = (search_progress*) malloc(sizeof(search_progress));
+    if(copy != NULL) {
+        memcpy(copy, p, sizeof(search_progress));
+        g_idle_add(show_progress, copy);
+    }
+}
+
+gboolean show_progress(gpointer data)
+{
+    search_progress* p = (search_progress*) data;
+
+    if(solving) {
+        char* text = NULL;
+        if(!p->found) {
+            text = g_strdup_printf("%ld nodes, %.0lf nodes/s, depth %i. "
+                                   "No solution yet.",
+                                   p->nodes, p->rate, p->depth);
+        } else if(!p->bounded) {
+            text = g_strdup_printf("%ld nodes, %.0lf nodes/s, depth %i. "
+                                   "Best: " NUMBER_FORMAT ".",
+                                   p->nodes, p->rate, p->depth, p->alpha);
         } else {
-            char* error = g_strdup_printf("Unable to convert report to PDF.\n"
-                                          "Status: %i.", as_pdf);
-            show_error(window, error);
-            g_free(error);
+            text = g_strdup_printf("%ld nodes, %.0lf nodes/s, depth %i. "
+                                   "Best: " NUMBER_FORMAT ", bound: "
+                                   NUMBER_FORMAT ".",
+                                   p->nodes, p->rate, p->depth, p->alpha,
+                                   p->bound);
+        }
+        gtk_progress_bar_set_text(progress, text);
+        g_free(text);
+    }
+
+    free(p);
+    return G_SOURCE_REMOVE;
+}
+
+gboolean show_stage(gpointer data)
+{
+    gtk_progress_bar_set_text(progress, (char*) data);
+    gtk_widget_set_sensitive(cancel_button, false);
+    return G_SOURCE_REMOVE;
+}
+
+gboolean show_result(gpointer data)
+{
+    solve_job* job = (solve_job*) data;
+
+    solving = false;
+    gtk_widget_hide(GTK_WIDGET(progress));
+    gtk_widget_set_sensitive(cancel_button, false);
+    gtk_widget_set_sensitive(process_button, true);
+
+    if(!job->success) {
+        switch(job->c->status) {
+            case status_out_of_range:
+                show_error(window, "The coefficients are too big.\n"
+                                   "Please use smaller ones or build with "
+                                   "bigger coefficients.");
+                break;
+            case status_no_memory:
+                show_error(window, "Not enough memory to solve the model.");
+                break;
+            default:
+                show_error(window, "Error while processing the information.\n"
+                                   "Please check your data.");
         }
     }
+
+    if(!job->report_created) {
+        show_error(window, "Report could not be created.\n"
+                           "Please check your data.");
+    } else if(job->as_pdf == 0) {
+        DEBUG("PDF version available at reports/implicit.pdf\n");
+    } else {
+        char* error = g_strdup_printf("Unable to convert report to PDF.\n"
+                                      "Status: %i.", job->as_pdf);
+        show_error(window, error);
+        g_free(error);
+    }
+
+    free(job);
+    return G_SOURCE_REMOVE;
+}
+
+gboolean pulse(gpointer data)
+{
+    if(!solving) {
+        pulsing = 0;
+        return G_SOURCE_REMOVE;
+    }
+    gtk_progress_bar_pulse(progress);
+    return G_SOURCE_CONTINUE;
 }
 
 void save_cb(GtkButton* button, gpointer user_data)
@@ -0,0 +1,293 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "heuristics.h"
+#include "activity.h"
+#include "lp.h"
+
+typedef struct {
+    bip_context* c;
+    activity* a;
+    GTimer* timer;
+    long moves;
+    number* alpha;
+    assignment* candidate;
+    bool found;
+} heuristics;
+
+typedef struct {
+    double ratio;
+    int var;
+} ranked;
+
+static bool out_of_time(heuristics* h)
+{
+    return !h->c->deterministic &&
+           (g_timer_elapsed(h->timer, NULL) > h->c->heuristics_time);
+}
+
+/* Keep the solution at the activity if it is the best so far */
+static void offer(heuristics* h)
+{
+    activity* a = h->a;
+    number value = a->fixed_perf;
+    if((a->violated != 0) || (assignment_count(a->fixed) != a->num_vars)) {
+        return;
+    }
+    if((h->c->maximize && (value > *h->alpha)) ||
+       (!h->c->maximize && (value < *h->alpha))) {
+        *h->alpha = value;
+        assignment_copy(a->fixed, h->candidate);
+        h->found = true;
+    }
+}
+
+/* Fix a variable, FALSE if that makes a restriction unreachable */
+static bool try_fix(heuristics* h, int var, int value)
+{
+    activity* a = h->a;
+    activity_fix(a, var, value);
+    if(a->unreachable > 0) {
+        return false;
+    }
+    return !h->c->propagate || activity_propagate(a, var);
+}
+
+static int by_ratio(const void* x, const void* y)
+{
+    const ranked* p = (const ranked*) x;
+    const ranked* q = (const ranked*) y;
+    if(p->ratio != q->ratio) {
+        return (p->ratio > q->ratio) ? -1 : 1;
+    }
+    return p->var - q->var;
+}
+
+/* Greedy rounding, FALSE if it got stuck */
+static bool greedy(heuristics* h)
+{
+    activity* a = h->a;
+    sparse* s = a->rests;
+    int n = a->num_vars;
+
+    ranked* order = (ranked*) malloc(n * sizeof(ranked));
+    if(order == NULL) {
+        return false;
+    }
+    for(int j = 0; j < n; j++) {
+        double use = 0.0;
+        for(int k = s->col_start[j]; k < s->col_start[j + 1]; k++) {
+            use += fabs(s->col_value[k]) /
+                   (fabs(a->equl[s->col_row[k]]) + 1);
+        }
+        order[j].ratio = fabs(a->perf[j]) / (1.0 + use);
+        order[j].var = j;
+    }
+    qsort(order, n, sizeof(ranked), by_ratio);
+
+    bool stuck = false;
+    for(int k = 0; !stuck && (k < n); k++) {
+        int var = order[k].var;
+        if(assignment_get(a->fixed, var) != -1) {
+            continue;
+        }
+        int value = assignment_get(a->best, var);
+        int mark = a->trail_size;
+        if(!try_fix(h, var, value)) {
+            activity_undo(a, mark);
+            activity_release(a, var);
+            stuck = !try_fix(h, var, 1 - value);
+        }
+    }
+
+    free(order);
+    return !stuck && (a->violated == 0);
+}
+
+/* Change of the objective flipping a variable, positive if it improves */
+static number gain(heuristics* h, int var)
+{
+    activity* a = h->a;
+    number delta = a->perf[var] * (1 - 2 * assignment_get(a->fixed, var));
+    return h->c->maximize ? delta : -delta;
+}
+
+static void flip(heuristics* h, int var)
+{
+    int value = assignment_get(h->a->fixed, var);
+    activity_release(h->a, var);
+    activity_fix(h->a, var, 1 - value);
+    h->moves++;
+}
+
+/* Improve the factible solution at the activity, flipping one variable or
+ * two when the first alone is not factible */
+static void local_search(heuristics* h)
+{
+    activity* a = h->a;
+    int n = a->num_vars;
+
+    bool improved = true;
+    for(int pass = 0; improved && (pass < HEURISTICS_PASSES); pass++) {
+        improved = false;
+
+        for(int j = 0; j < n; j++) {
+            number first = gain(h, j);
+            if(first <= 0) {
+                continue;
+            }
+            flip(h, j);
+            if(a->violated == 0) {
+                improved = true;
+                continue;
+            }
+
+            /* Repair it with a second flip */
+            bool repaired = false;
+            for(int k = 0; !repaired && (k < n); k++) {
+                if((k == j) || (first + gain(h, k) <= 0)) {
+                    continue;
+                }
+                flip(h, k);
+                repaired = (a->violated == 0);
+                if(!repaired) {
+                    flip(h, k);
+                }
+            }
+            if(repaired) {
+                improved = true;
+            } else {
+                flip(h, j);
+            }
+
+            if((h->moves > HEURISTICS_MOVES) || out_of_time(h)) {
+                return;
+            }
+        }
+    }
+}
+
+/* Feasibility pump, FALSE if no factible rounding was found */
+static bool pump(heuristics* h, assignment* point, assignment* last)
+{
+    activity* a = h->a;
+    int n = a->num_vars;
+
+    lp* l = lp_new(h->c);
+    double* x = (double*) malloc(n * sizeof(double));
+    if((l == NULL) || (x == NULL)) {
+        lp_free(l);
+        free(x);
+        return false;
+    }
+
+    /* Start at the relaxation of the model */
+    double z = 0.0;
+    assignment_clear(point);
+    bool factible = lp_bound(l, point, &z);
+    lp_values(l, x);
+
+    bool found = false;
+    for(int round = 0; factible && !found && (round < HEURISTICS_PUMP) &&
+                       !out_of_time(h); round++) {
+
+        for(int j = 0; j < n; j++) {
+            assignment_set(point, j, x[j] > 0.5 ? 1 : 0);
+        }
+
+        /* Cycling, flip the variables furthest from their rounding */
+        bool cycle = (round > 0) &&
+            (memcmp(point->value, last->value,
+                    point->words * sizeof(uint64_t)) == 0);
+        for(int f = 0; cycle && (f < min(HEURISTICS_FLIP, n)); f++) {
+            int var = -1;
+            double furthest = -1.0;
+            for(int j = 0; j < n; j++) {
+                double d = fabs(x[j] - assignment_get(point, j));
+                if((assignment_get(point, j) == assignment_get(last, j)) &&
+                   (d > furthest)) {
+                    furthest = d;
+                    var = j;
+                }
+            }
+            assignment_set(point, var, 1 - assignment_get(point, var));
+        }
+
+        activity_move(a, point);
+        found = (a->violated == 0);
+        assignment_copy(point, last);
+        if(!found) {
+            factible = lp_distance(l, point, x);
+        }
+    }
+
+    lp_free(l);
+    free(x);
+    return found;
+}
+
+bool heuristics_run(bip_context* c, number* alpha, assignment* candidate)
+{
+    int n = c->num_vars;
+    if(n == 0) {
+        return false;
+    }
+
+    heuristics h;
+    h.c = c;
+    h.moves = 0;
+    h.alpha = alpha;
+    h.candidate = candidate;
+    h.found = false;
+
+    /* Try to allocate memory */
+    h.a = activity_new(c);
+    assignment* point = assignment_new(n);
+    assignment* last = assignment_new(n);
+    if((h.a == NULL) || (point == NULL) || (last == NULL)) {
+        activity_free(h.a);
+        assignment_free(point);
+        assignment_free(last);
+        return false;
+    }
+    h.timer = g_timer_new();
+
+    if(greedy(&h)) {
+        local_search(&h);
+        offer(&h);
+    }
+
+    /* Back to the root */
+    activity_undo(h.a, 0);
+    assignment_clear(point);
+    activity_move(h.a, point);
+
+    if(!out_of_time(&h) && pump(&h, point, last)) {
+        local_search(&h);
+        offer(&h);
+    }
+    DEBUG("Heuristics: %s after %.3f seconds.\n",
+          h.found ? "solution found" : "nothing found",
+          g_timer_elapsed(h.timer, NULL));
+
+    g_timer_destroy(h.timer);
+    activity_free(h.a);
+    assignment_free(point);
+    assignment_free(last);
+    return h.found;
+}
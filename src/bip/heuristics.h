@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_HEURISTICS
+#define H_HEURISTICS
+
+#include "bip.h"
+#include "assignment.h"
+
+/* Default time budget, in seconds */
+#define HEURISTICS_TIME 0.1
+
+/* Work limits, the only ones in a deterministic search */
+#define HEURISTICS_PUMP 50          /* Rounds of the feasibility pump */
+#define HEURISTICS_FLIP 10          /* Variables flipped when it cycles */
+#define HEURISTICS_PASSES 20        /* Passes of the local search */
+#define HEURISTICS_MOVES 1000000    /* Flips tried by the local search */
+
+/**
+ * Look for a good solution before the search, so it prunes from the start.
+ *
+ *     Greedy rounding  Variables are fixed by decreasing ratio of objective
+ *                      coefficient to use of the restrictions, each to its
+ *                      best fit value unless that makes a restriction
+ *                      unreachable, propagating if enabled.
+ *     Feasibility pump The LP relaxation is rounded and then moved to the
+ *                      closest factible point of the relaxation, until the
+ *                      rounding is factible. When it cycles, the variables
+ *                      furthest from their rounding are flipped. Only if the
+ *                      relaxation fits, see lp.h.
+ *     Local search     Every solution found is improved flipping one
+ *                      variable, or two if the first flip alone is not
+ *                      factible, until no flip improves it.
+ *
+ * The stage stops after 'heuristics_time' seconds. In a deterministic search
+ * only the work limits apply, so the result doesn't depend on the timing.
+ *
+ * @param c, the binary integer programming context data structure.
+ * @param alpha, the performance to improve, updated if a better solution is
+ *        found.
+ * @param candidate, where to store the solution found.
+ * @return TRUE if a solution better than alpha was found.
+ */
+bool heuristics_run(bip_context* c, number* alpha, assignment* candidate);
+
+#endif
@@ -0,0 +1,485 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "lp.h"
+#include "kernels.h"
+#include <stddef.h>
+
+static double* row(lp* l, double* table, int i)
+{
+    return table + ((ptrdiff_t) i * l->width);
+}
+
+/* Free variables are nonbasic at the bound their reduced cost asks for, so
+ * the basis stays dual factible */
+static void place(lp* l, int j)
+{
+    l->x[j] = (l->cost[j] >= 0) ? l->lower[j] : l->upper[j];
+}
+
+/* Basis of slacks, always regular and dual factible */
+static void slack_basis(lp* l)
+{
+    int n = l->num_vars;
+    int m = l->num_rest;
+
+    memcpy(l->tableau, l->model, (size_t) m * l->width * sizeof(double));
+    for(int j = 0; j < l->cols; j++) {
+        l->cost[j] = l->obj[j];
+        l->basic[j] = (j >= n);
+    }
+    for(int i = 0; i < m; i++) {
+        l->head[i] = n + i;
+    }
+    for(int j = 0; j < n; j++) {
+        place(l, j);
+    }
+    l->pivots = 0;
+}
+
+static void pivot(lp* l, int r, int q)
+{
+    int m = l->num_rest;
+    int width = l->width;
+    double* pr = row(l, l->tableau, r);
+
+    double p = pr[q];
+    for(int j = 0; j < width; j++) {
+        pr[j] /= p;
+    }
+    pr[q] = 1.0;
+
+    for(int i = 0; i < m; i++) {
+        if(i == r) {
+            continue;
+        }
+        double* pi = row(l, l->tableau, i);
+        double f = pi[q];
+        if(f == 0.0) {
+            continue;
+        }
+        kernel_axpy(pi, -f, pr, width);
+        pi[q] = 0.0;
+    }
+
+    double f = l->cost[q];
+    if(f != 0.0) {
+        kernel_axpy(l->cost, -f, pr, l->cols);
+        l->cost[q] = 0.0;
+    }
+
+    l->basic[l->head[r]] = false;
+    l->basic[q] = true;
+    l->head[r] = q;
+    l->pivots++;
+    l->iterations++;
+}
+
+/* Rebuild the tableau of the current basis from the model */
+static void refactor(lp* l)
+{
+    int m = l->num_rest;
+    int width = l->width;
+
+    memcpy(l->tableau, l->model, (size_t) m * width * sizeof(double));
+    for(int k = 0; k < m; k++) {
+
+        /* Partial pivoting among the rows left */
+        int q = l->head[k];
+        int r = -1;
+        double best = LP_EPSILON;
+        for(int i = k; i < m; i++) {
+            double v = fabs(row(l, l->tableau, i)[q]);
+            if(v > best) {
+                best = v;
+                r = i;
+            }
+        }
+        if(r == -1) {
+            slack_basis(l);
+            return;
+        }
+        if(r != k) {
+            double* a = row(l, l->tableau, r);
+            double* b = row(l, l->tableau, k);
+            for(int j = 0; j < width; j++) {
+                double t = a[j];
+                a[j] = b[j];
+                b[j] = t;
+            }
+        }
+
+        double* pk = row(l, l->tableau, k);
+        double p = pk[q];
+        for(int j = 0; j < width; j++) {
+            pk[j] /= p;
+        }
+        for(int i = 0; i < m; i++) {
+            if(i == k) {
+                continue;
+            }
+            double* pi = row(l, l->tableau, i);
+            double f = pi[q];
+            if(f == 0.0) {
+                continue;
+            }
+            kernel_axpy(pi, -f, pk, width);
+        }
+    }
+
+    /* Reduced costs */
+    for(int j = 0; j < l->cols; j++) {
+        l->cost[j] = l->obj[j];
+    }
+    for(int i = 0; i < m; i++) {
+        double f = l->obj[l->head[i]];
+        if(f == 0.0) {
+            continue;
+        }
+        double* pi = row(l, l->tableau, i);
+        kernel_axpy(l->cost, -f, pi, l->cols);
+    }
+    l->pivots = 0;
+}
+
+/* Value of the basic columns from the nonbasic ones */
+static void basics(lp* l)
+{
+    for(int i = 0; i < l->num_rest; i++) {
+        double* pi = row(l, l->tableau, i);
+        double v = pi[l->cols];
+        for(int j = 0; j < l->cols; j++) {
+            if(!l->basic[j] && (l->x[j] != 0.0)) {
+                v -= pi[j] * l->x[j];
+            }
+        }
+        l->x[l->head[i]] = v;
+    }
+}
+
+/* Apply the bounds of the fixed variables that changed */
+static void sync(lp* l, assignment* fixed)
+{
+    for(int w = 0; w < fixed->words; w++) {
+        uint64_t diff = (l->fixed->mask[w] ^ fixed->mask[w]) |
+                        (l->fixed->value[w] ^ fixed->value[w]);
+        while(diff != 0) {
+            int j = (w * ASSIGNMENT_BITS) + __builtin_ctzll(diff);
+            diff &= diff - 1;
+
+            int value = assignment_get(fixed, j);
+            if(value == -1) {
+                l->lower[j] = 0.0;
+                l->upper[j] = 1.0;
+            } else {
+                l->lower[j] = value;
+                l->upper[j] = value;
+            }
+            if(!l->basic[j]) {
+                place(l, j);
+            }
+        }
+    }
+    assignment_copy(fixed, l->fixed);
+}
+
+lp* lp_new(bip_context* c)
+{
+    int n = c->num_vars;
+    int m = c->num_rest;
+
+    /* Check the tableau fits */
+    double cells = 2.0 * m * (n + m + 1);
+    if(cells > LP_MAX_CELLS) {
+        return NULL;
+    }
+
+    /* Allocate structure */
+    lp* l = (lp*) malloc(sizeof(lp));
+    if(l == NULL) {
+        return NULL;
+    }
+    l->num_vars = n;
+    l->num_rest = m;
+    l->maximize = c->maximize;
+    l->cols = n + m;
+    l->width = n + m + 1;
+    l->iterations = 0;
+    l->optimal = false;
+
+    /* Try to allocate dynamic memory */
+    size_t size = (size_t) m * l->width + 1;
+    l->model   = (double*) calloc(size, sizeof(double));
+    l->tableau = (double*) malloc(size * sizeof(double));
+    l->obj     = (double*) malloc(l->cols * sizeof(double));
+    l->func    = (double*) malloc((n + 1) * sizeof(double));
+    l->cost    = (double*) malloc(l->cols * sizeof(double));
+    l->lower   = (double*) malloc(l->cols * sizeof(double));
+    l->upper   = (double*) malloc(l->cols * sizeof(double));
+    l->x       = (double*) malloc(l->cols * sizeof(double));
+    l->head    = (int*) malloc((m + 1) * sizeof(int));
+    l->basic   = (bool*) malloc(l->cols * sizeof(bool));
+    l->fixed   = assignment_new(n);
+    if((l->model == NULL) || (l->tableau == NULL) || (l->obj == NULL) ||
+       (l->func == NULL) || (l->cost == NULL) || (l->lower == NULL) ||
+       (l->upper == NULL) || (l->x == NULL) || (l->head == NULL) ||
+       (l->basic == NULL) || (l->fixed == NULL)) {
+        lp_free(l);
+        return NULL;
+    }
+
+    /* Restrictions with their slack, as LE or EQ. Each one is divided by
+     * its largest coefficient, so the tolerances hold for any magnitude. */
+    for(int i = 0; i < m; i++) {
+        double* mi = row(l, l->model, i);
+        int type = rest_type(c, i);
+        double largest = 0.0;
+        for(int j = 0; j < n; j++) {
+            largest = fmax(largest, fabs(rest_coeff(c, i, j)));
+        }
+        double sign = (type == GE) ? -1.0 : 1.0;
+        if(largest > 0.0) {
+            sign /= largest;
+        }
+        for(int j = 0; j < n; j++) {
+            mi[j] = sign * rest_coeff(c, i, j);
+        }
+        mi[n + i] = 1.0;
+        mi[l->cols] = sign * rest_equl(c, i);
+
+        l->obj[n + i] = 0.0;
+        l->lower[n + i] = 0.0;
+        l->upper[n + i] = (type == EQ) ? 0.0 : HUGE_VAL;
+        l->x[n + i] = 0.0;
+    }
+
+    /* Variables, the objective divided by its largest coefficient too */
+    l->scale = 0.0;
+    for(int j = 0; j < n; j++) {
+        l->scale = fmax(l->scale, fabs(c->function[j]));
+    }
+    if(l->scale == 0.0) {
+        l->scale = 1.0;
+    }
+    for(int j = 0; j < n; j++) {
+        l->obj[j] = (c->maximize ? -c->function[j] : c->function[j]) /
+                    l->scale;
+        l->func[j] = l->obj[j];
+        l->lower[j] = 0.0;
+        l->upper[j] = 1.0;
+    }
+
+    slack_basis(l);
+    return l;
+}
+
+/* Dual simplex from a dual factible basis, FALSE if not factible */
+static bool solve(lp* l)
+{
+    basics(l);
+
+    int limit = 2 * l->cols + 50;
+    bool retried = false;
+    l->optimal = false;
+    for(int it = 0; it < limit; it++) {
+
+        if(l->pivots >= LP_REFACTOR) {
+            refactor(l);
+            basics(l);
+        }
+
+        /* Leaving row, the most infeasible basic column */
+        int r = -1;
+        double worst = LP_FEASIBLE;
+        for(int i = 0; i < l->num_rest; i++) {
+            int b = l->head[i];
+            double v = l->x[b];
+            double inf = 0.0;
+            if(v < l->lower[b]) {
+                inf = l->lower[b] - v;
+            } else if(v > l->upper[b]) {
+                inf = v - l->upper[b];
+            }
+            if(inf > worst) {
+                worst = inf;
+                r = i;
+            }
+        }
+        if(r == -1) {
+            l->optimal = true;
+            break;
+        }
+        int leaving = l->head[r];
+        bool below = l->x[leaving] < l->lower[leaving];
+
+        /* Entering column, dual ratio test */
+        double* pr = row(l, l->tableau, r);
+        int q = -1;
+        double ratio = HUGE_VAL;
+        double size = 0.0;
+        for(int j = 0; j < l->cols; j++) {
+            double a = pr[j];
+            if(l->basic[j] || (l->lower[j] == l->upper[j]) ||
+               (fabs(a) < LP_EPSILON)) {
+                continue;
+            }
+            bool at_lower = (l->x[j] <= l->lower[j]);
+            bool from_lower = below ? (a < 0) : (a > 0);
+            if(from_lower != at_lower) {
+                continue;
+            }
+            double t = fabs(l->cost[j]) / fabs(a);
+            if((t < ratio - LP_EPSILON) ||
+               ((t < ratio + LP_EPSILON) && (fabs(a) > size))) {
+                ratio = t;
+                size = fabs(a);
+                q = j;
+            }
+        }
+
+        /* Dual unbounded, not factible. Make sure it isn't rounding. */
+        if(q == -1) {
+            if(!retried && (l->pivots > 0)) {
+                retried = true;
+                refactor(l);
+                basics(l);
+                continue;
+            }
+            return false;
+        }
+
+        l->x[leaving] = below ? l->lower[leaving] : l->upper[leaving];
+        pivot(l, r, q);
+        basics(l);
+    }
+    return true;
+}
+
+bool lp_bound(lp* l, assignment* fixed, double* bound)
+{
+    sync(l, fixed);
+    if(!solve(l)) {
+        return false;
+    }
+
+    /* The dual objective bounds the relaxation even if the limit stopped the
+     * simplex before the optimum */
+    double z = 0.0;
+    for(int j = 0; j < l->num_vars; j++) {
+        z += l->obj[j] * l->x[j];
+    }
+    *bound = l->scale * (l->maximize ? -z : z);
+    return true;
+}
+
+bool lp_distance(lp* l, assignment* point, double* x)
+{
+    /* The slack basis is dual factible for any objective */
+    for(int j = 0; j < l->num_vars; j++) {
+        l->obj[j] = (assignment_get(point, j) == 1) ? -1.0 : 1.0;
+    }
+    slack_basis(l);
+    bool factible = solve(l);
+    memcpy(x, l->x, l->num_vars * sizeof(double));
+
+    /* Back to the objective of the model */
+    memcpy(l->obj, l->func, l->num_vars * sizeof(double));
+    slack_basis(l);
+    return factible;
+}
+
+void lp_warm(lp* l, lp* from, int* rows)
+{
+    int n = l->num_vars;
+
+    for(int j = 0; j < l->cols; j++) {
+        l->basic[j] = (j >= n);
+    }
+    for(int j = 0; j < n; j++) {
+        l->basic[j] = from->basic[j];
+    }
+    for(int i = 0; i < from->num_rest; i++) {
+        if(rows[i] != -1) {
+            l->basic[n + rows[i]] = from->basic[n + i];
+        }
+    }
+
+    /* A removed restriction had to take its basic column with it */
+    int k = 0;
+    for(int j = 0; j < l->cols; j++) {
+        if(l->basic[j] && (k < l->num_rest)) {
+            l->head[k] = j;
+        }
+        k += l->basic[j] ? 1 : 0;
+    }
+    if(k != l->num_rest) {
+        slack_basis(l);
+        return;
+    }
+
+    refactor(l);
+    for(int j = 0; j < l->cols; j++) {
+        if(l->basic[j]) {
+            continue;
+        }
+        if(j < n) {
+            place(l, j);
+        } else {
+            l->x[j] = l->lower[j];
+        }
+    }
+}
+
+void lp_values(lp* l, double* x)
+{
+    memcpy(x, l->x, l->num_vars * sizeof(double));
+}
+
+unsigned int lp_sizeof(lp* l)
+{
+    if(l == NULL) {
+        return 0;
+    }
+    size_t cells = (size_t) l->num_rest * l->width + 1;
+    return sizeof(lp) +
+           (2 * cells * sizeof(double)) +
+           (5 * l->cols * sizeof(double)) +
+           ((l->num_vars + 1) * sizeof(double)) +
+           ((l->num_rest + 1) * sizeof(int)) +
+           (l->cols * sizeof(bool)) +
+           assignment_sizeof(l->fixed);
+}
+
+void lp_free(lp* l)
+{
+    if(l == NULL) {
+        return;
+    }
+    free(l->model);
+    free(l->tableau);
+    free(l->obj);
+    free(l->func);
+    free(l->cost);
+    free(l->lower);
+    free(l->upper);
+    free(l->x);
+    free(l->head);
+    free(l->basic);
+    assignment_free(l->fixed);
+    free(l);
+}
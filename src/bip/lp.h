@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_LP
+#define H_LP
+
+#include "bip.h"
+#include "assignment.h"
+
+/* Models with a bigger tableau than this are not relaxed */
+#define LP_MAX_CELLS 4000000
+
+/* Pivots between two refactorizations of the tableau */
+#define LP_REFACTOR 64
+
+#define LP_EPSILON 0.000000001
+#define LP_FEASIBLE 0.000001
+
+/**
+ * Linear programming relaxation of a model.
+ *
+ * Solved with a bounded variable dual simplex on a dense tableau. Each
+ * restriction gets a slack (GE restrictions are negated to LE, the slack of
+ * an EQ restriction is fixed to 0) and every variable is bounded to [0, 1],
+ * or to its value if fixed. Changing bounds keeps the basis dual factible,
+ * so each solve warm starts from the basis of the previous one, which in a
+ * depth first search is the parent node or a close relative. The tableau is
+ * rebuilt from the model every LP_REFACTOR pivots to drop rounding errors.
+ * Restrictions and objective are scaled to a largest coefficient of 1. Row
+ * operations use the vector kernels, see kernels.h.
+ */
+typedef struct {
+
+    int num_vars;
+    int num_rest;
+    bool maximize;
+    int cols;           /* Variables plus slacks */
+    int width;          /* cols plus the right hand side */
+
+    double* model;      /* [A | I | b] */
+    double* tableau;    /* B^-1 [A | I | b] */
+    double* obj;        /* Objective in use, minimizing */
+    double* func;       /* Objective of the model, divided by 'scale' */
+    double scale;
+    double* cost;       /* Reduced costs */
+    double* lower;
+    double* upper;
+    double* x;          /* Value of each column */
+    int* head;          /* Basic column of each row */
+    bool* basic;
+
+    assignment* fixed;  /* Bounds currently applied */
+    int pivots;         /* Since the last refactorization */
+    long iterations;
+    bool optimal;       /* FALSE if the last solve stopped at its limit */
+
+} lp;
+
+/**
+ * Create the relaxation of a model, with all variables free.
+ *
+ * @param c, the binary integer programming context data structure.
+ * @return a pointer to the relaxation or NULL if the model is too big or
+ *         enough memory could not be allocated.
+ */
+lp* lp_new(bip_context* c);
+
+/**
+ * Solve the relaxation with the given variables fixed.
+ *
+ * @param l, the relaxation (by reference)
+ * @param fixed, the fixed variables.
+ * @param bound, where to store the performance of the relaxation, a bound of
+ *        the performance of any solution with those variables fixed. The
+ *        simplex stops after 2 * (num_vars + num_rest) + 50 pivots, in which
+ *        case it is still a bound but the solution is not optimal, see
+ *        'optimal'. Another call goes on from there.
+ * @return FALSE if the relaxation is not factible, so neither is the model
+ *         with those variables fixed.
+ */
+bool lp_bound(lp* l, assignment* fixed, double* bound);
+
+/**
+ * Solve the relaxation minimizing the distance to a binary point instead of
+ * the objective of the model, with the bounds of the last lp_bound() call.
+ * The next lp_bound() starts again from the basis of slacks.
+ *
+ * @param l, the relaxation (by reference)
+ * @param point, the binary point, with all variables fixed.
+ * @param x, where to store the value of each variable in the solution.
+ * @return FALSE if the relaxation is not factible.
+ */
+bool lp_distance(lp* l, assignment* point, double* x);
+
+/**
+ * Start from the basis of another relaxation of the same variables, whose
+ * restrictions are kept in this one and whose basis is dual factible. The
+ * slacks of the restrictions new to this one are basic, so the basis is
+ * still dual factible and the next lp_bound() only has to restore primal
+ * factibility.
+ *
+ * @param l, the relaxation (by reference)
+ * @param from, the other relaxation.
+ * @param rows, the restriction of 'l' for each one of 'from', -1 if it was
+ *        removed, which requires its slack to be basic.
+ * @return nothing
+ */
+void lp_warm(lp* l, lp* from, int* rows);
+
+/**
+ * Copy the value of each variable in the solution of the last lp_bound().
+ *
+ * @param l, the relaxation (by reference)
+ * @param x, the destination vector.
+ * @return nothing
+ */
+void lp_values(lp* l, double* x);
+
+/**
+ * Calculates the memory required by the relaxation.
+ *
+ * @return the size of the relaxation in bytes.
+ * @param l, the relaxation (by reference)
+ */
+unsigned int lp_sizeof(lp* l);
+
+/**
+ * Free resources associated with a relaxation.
+ *
+ * @return nothing
+ * @param l, the relaxation (by reference)
+ */
+void lp_free(lp* l);
+
+#endif
@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "nogood.h"
+
+static void unlink_cell(nogood_db* d, int cell)
+{
+    int lit = d->lits[cell];
+    if(d->prev[cell] == -1) {
+        d->head[lit] = d->next[cell];
+    } else {
+        d->next[d->prev[cell]] = d->next[cell];
+    }
+    if(d->next[cell] != -1) {
+        d->prev[d->next[cell]] = d->prev[cell];
+    }
+}
+
+static void remove_slot(nogood_db* d, int s)
+{
+    if(d->holding[s] == d->size[s]) {
+        d->conflicts--;
+    }
+    for(int k = 0; k < d->size[s]; k++) {
+        unlink_cell(d, (s * NOGOOD_LENGTH) + k);
+    }
+    d->size[s] = 0;
+}
+
+/* Clock sweep, a free slot or one that closed no node since last time */
+static int victim(nogood_db* d)
+{
+    while(true) {
+        int s = d->hand;
+        d->hand = (d->hand + 1) % d->slots;
+        if((d->size[s] == 0) || (d->hits[s] == 0)) {
+            return s;
+        }
+        d->hits[s] /= 2;
+    }
+}
+
+nogood_db* nogood_new(int num_vars, int slots)
+{
+    /* Allocate structure */
+    nogood_db* d = (nogood_db*) malloc(sizeof(nogood_db));
+    if(d == NULL) {
+        return NULL;
+    }
+    d->num_vars = num_vars;
+    d->slots = slots;
+
+    /* Try to allocate dynamic memory */
+    int cells = slots * NOGOOD_LENGTH;
+    d->lits    = (int*) malloc(cells * sizeof(int));
+    d->size    = (int*) malloc(slots * sizeof(int));
+    d->holding = (int*) malloc(slots * sizeof(int));
+    d->hits    = (int*) malloc(slots * sizeof(int));
+    d->head    = (int*) malloc((2 * num_vars + 1) * sizeof(int));
+    d->next    = (int*) malloc(cells * sizeof(int));
+    d->prev    = (int*) malloc(cells * sizeof(int));
+    if((d->lits == NULL) || (d->size == NULL) || (d->holding == NULL) ||
+       (d->hits == NULL) || (d->head == NULL) || (d->next == NULL) ||
+       (d->prev == NULL)) {
+        nogood_free(d);
+        return NULL;
+    }
+
+    nogood_forget(d);
+    return d;
+}
+
+void nogood_set(nogood_db* d, int var, int value)
+{
+    for(int cell = d->head[(2 * var) + value]; cell != -1;
+        cell = d->next[cell]) {
+        int s = cell / NOGOOD_LENGTH;
+        d->holding[s]++;
+        if(d->holding[s] == d->size[s]) {
+            d->conflicts++;
+            d->hits[s]++;
+        }
+    }
+}
+
+void nogood_unset(nogood_db* d, int var, int value)
+{
+    for(int cell = d->head[(2 * var) + value]; cell != -1;
+        cell = d->next[cell]) {
+        int s = cell / NOGOOD_LENGTH;
+        if(d->holding[s] == d->size[s]) {
+            d->conflicts--;
+        }
+        d->holding[s]--;
+    }
+}
+
+int nogood_unit(nogood_db* d, int lit, assignment* fixed)
+{
+    for(int cell = d->head[lit]; cell != -1; cell = d->next[cell]) {
+        int s = cell / NOGOOD_LENGTH;
+        if(d->holding[s] != d->size[s] - 1) {
+            continue;
+        }
+        for(int k = 0; k < d->size[s]; k++) {
+            int left = d->lits[(s * NOGOOD_LENGTH) + k];
+            if(assignment_get(fixed, left / 2) == -1) {
+                d->hits[s]++;
+                return left;
+            }
+        }
+    }
+    return -1;
+}
+
+void nogood_add(nogood_db* d, int* lits, int size)
+{
+    int s = victim(d);
+    if(d->size[s] != 0) {
+        remove_slot(d, s);
+    }
+
+    for(int k = 0; k < size; k++) {
+        int cell = (s * NOGOOD_LENGTH) + k;
+        int lit = lits[k];
+        d->lits[cell] = lit;
+        d->prev[cell] = -1;
+        d->next[cell] = d->head[lit];
+        if(d->head[lit] != -1) {
+            d->prev[d->head[lit]] = cell;
+        }
+        d->head[lit] = cell;
+    }
+    d->size[s] = size;
+    d->holding[s] = size;
+    d->hits[s] = 0;
+    d->conflicts++;
+    d->learnt++;
+}
+
+void nogood_forget(nogood_db* d)
+{
+    for(int s = 0; s < d->slots; s++) {
+        d->size[s] = 0;
+    }
+    for(int l = 0; l < 2 * d->num_vars; l++) {
+        d->head[l] = -1;
+    }
+    d->hand = 0;
+    d->conflicts = 0;
+    d->learnt = 0;
+}
+
+unsigned int nogood_sizeof(nogood_db* d)
+{
+    if(d == NULL) {
+        return 0;
+    }
+    int cells = d->slots * NOGOOD_LENGTH;
+    return sizeof(nogood_db) +
+           (3 * cells * sizeof(int)) +
+           (3 * d->slots * sizeof(int)) +
+           ((2 * d->num_vars + 1) * sizeof(int));
+}
+
+void nogood_free(nogood_db* d)
+{
+    if(d == NULL) {
+        return;
+    }
+    free(d->lits);
+    free(d->size);
+    free(d->holding);
+    free(d->hits);
+    free(d->head);
+    free(d->next);
+    free(d->prev);
+    free(d);
+}
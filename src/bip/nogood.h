@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef H_NOGOOD
+#define H_NOGOOD
+
+#include "bip.h"
+#include "assignment.h"
+
+/* Default number of nogoods kept */
+#define NOGOOD_SLOTS 4096
+
+/* Literals of a nogood, longer ones are not learnt */
+#define NOGOOD_LENGTH 16
+
+/**
+ * Database of learnt nogoods, sets of variable values that no factible
+ * solution has all at once.
+ *
+ * A literal is 2 * var + value. Each nogood counts how many of its literals
+ * hold, updated when a variable is fixed or released walking the cells of
+ * that literal, so finding if some nogood holds completely is a counter
+ * test, and a nogood with all literals but one holding forbids the last
+ * one. The database has a fixed number of slots, once full a new nogood
+ * replaces the first one found that closed no node since it was last
+ * passed over, a clock sweep that halves the hits of the others.
+ */
+typedef struct {
+
+    int num_vars;
+    int slots;
+
+    /* NOGOOD_LENGTH cells per slot */
+    int* lits;
+    int* size;      /* Literals of each nogood, 0 if the slot is free */
+    int* holding;   /* Literals that hold */
+    int* hits;      /* Nodes closed */
+
+    /* Cells of each literal, as a doubly linked list */
+    int* head;
+    int* next;
+    int* prev;
+
+    int hand;       /* Next slot to consider for replacement */
+    int conflicts;  /* Nogoods with all their literals holding */
+    long learnt;
+
+} nogood_db;
+
+/**
+ * Create an empty database of nogoods.
+ *
+ * @param num_vars, the number of variables of the model.
+ * @param slots, the number of nogoods kept.
+ * @return a pointer to the database or NULL if enough memory could not be
+ *         allocated.
+ */
+nogood_db* nogood_new(int num_vars, int slots);
+
+/**
+ * Record that a variable was fixed.
+ *
+ * @param d, the database (by reference)
+ * @param var, the index of the variable.
+ * @param value, 0 or 1.
+ * @return nothing
+ */
+void nogood_set(nogood_db* d, int var, int value);
+
+/**
+ * Record that a fixed variable was released.
+ *
+ * @param d, the database (by reference)
+ * @param var, the index of the variable.
+ * @param value, the value it had.
+ * @return nothing
+ */
+void nogood_unset(nogood_db* d, int var, int value);
+
+/**
+ * Find a nogood of a literal that holds with every other literal holding but
+ * one whose variable is free, the value of that variable is forbidden.
+ *
+ * @param d, the database (by reference)
+ * @param lit, the literal, 2 * var + value.
+ * @param fixed, the fixed variables.
+ * @return the literal left, -1 if there is none.
+ */
+int nogood_unit(nogood_db* d, int lit, assignment* fixed);
+
+/**
+ * Add a nogood whose literals all hold, replacing another if full.
+ *
+ * @param d, the database (by reference)
+ * @param lits, the literals.
+ * @param size, the number of literals, 1 to NOGOOD_LENGTH.
+ * @return nothing
+ */
+void nogood_add(nogood_db* d, int* lits, int size);
+
+/**
+ * Drop every nogood.
+ *
+ * @param d, the database (by reference)
+ * @return nothing
+ */
+void nogood_forget(nogood_db* d);
+
+/**
+ * Calculates the memory required by the database.
+ *
+ * @return the size of the database in bytes.
+ * @param d, the database (by reference)
+ */
+unsigned int nogood_sizeof(nogood_db* d);
+
+/**
+ * Free resources associated with a database of nogoods.
+ *
+ * @return nothing
+ * @param d, the database (by reference)
+ */
+void nogood_free(nogood_db* d);
+
+#endif
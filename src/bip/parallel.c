@@ -0,0 +1,736 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "parallel.h"
+#include "activity.h"
+#include "branch.h"
+#include "report.h"
+#include "probe.h"
+
+/* Parallel search, shared alpha and no report work */
+#define IMPL_TRACE 0
+#define IMPL_PARALLEL 1
+#define IMPL_QUEUE 0
+#define IMPL_NAME(name) name##_parallel
+#include "implicit.inc"
+#undef IMPL_NAME
+#undef IMPL_QUEUE
+#undef IMPL_PARALLEL
+#undef IMPL_TRACE
+
+/* Deterministic rounds, each subtree has its own alpha */
+#define IMPL_TRACE 0
+#define IMPL_PARALLEL 0
+#define IMPL_QUEUE 0
+#define IMPL_NAME(name) name##_rounds
+#include "implicit.inc"
+#undef IMPL_NAME
+#undef IMPL_QUEUE
+#undef IMPL_PARALLEL
+#undef IMPL_TRACE
+
+/* Deterministic rounds, traced one subtree after the other */
+#define IMPL_TRACE 1
+#define IMPL_PARALLEL 0
+#define IMPL_QUEUE 0
+#define IMPL_NAME(name) name##_rounds_traced
+#include "implicit.inc"
+#undef IMPL_NAME
+#undef IMPL_QUEUE
+#undef IMPL_PARALLEL
+#undef IMPL_TRACE
+
+/* Subtree waiting in a deque */
+typedef struct {
+    assignment* fixed;
+    int depth;
+    number bound;       /* Best fit of the parent, bounds the subtree */
+    int* parents;       /* Node numbers of the path to the root, if traced */
+    int* branched;      /* Variables branched on along it, if traced */
+
+    /* Result, in deterministic rounds */
+    assignment* best;
+    number alpha;
+    long nodes;
+} parallel_task;
+
+typedef struct {
+    bip_context* c;
+    number* alpha;
+    int threads;
+    parallel_worker* workers;
+
+    /* Updated atomically */
+    int pending;    /* Tasks queued or being explored */
+    int idle;       /* Workers looking for a task */
+
+    /* Idle workers wait here until a task is pushed or none is pending */
+    GMutex wait;
+    GCond work;
+
+    /* Deterministic rounds */
+    parallel_task** round;
+    int round_size;
+    int next;       /* Next task of the round to explore, atomic */
+    number epoch;   /* Alpha at the start of the round */
+} parallel_pool;
+
+struct parallel_worker {
+    int id;
+    parallel_pool* pool;
+
+    /* Deque of tasks, newest at the tail */
+    GMutex lock;
+    GQueue* tasks;
+    int queued;     /* Length of the deque, read without the lock */
+
+    /* Search state */
+    activity* a;
+    assignment* candidate;
+    impl_frame* stack;
+    bool idle;
+    bool failed;
+    long nodes;
+    long reserved;  /* Memory counted in the budget */
+
+    /* Vectors for the report, only for the first worker if tracing */
+    int* fixed;
+    int* workplace;
+    int* parents;
+    int* branched;
+};
+
+static parallel_task* task_new(assignment* fixed, int depth, number bound)
+{
+    parallel_task* t = (parallel_task*) malloc(sizeof(parallel_task));
+    if(t == NULL) {
+        return NULL;
+    }
+    t->fixed = assignment_new(fixed->size);
+    if(t->fixed == NULL) {
+        free(t);
+        return NULL;
+    }
+    assignment_copy(fixed, t->fixed);
+    t->depth = depth;
+    t->bound = bound;
+    t->parents = NULL;
+    t->branched = NULL;
+    t->best = NULL;
+    t->alpha = 0;
+    t->nodes = 0;
+    return t;
+}
+
+static void task_free(gpointer data)
+{
+    parallel_task* t = (parallel_task*) data;
+    assignment_free(t->fixed);
+    assignment_free(t->best);
+    free(t->parents);
+    free(t->branched);
+    free(t);
+}
+
+/* Memory counted in the budget for a task, the result of a round is not */
+static long task_sizeof(parallel_task* t)
+{
+    long size = sizeof(parallel_task) + assignment_sizeof(t->fixed);
+    if(t->parents != NULL) {
+        size += (t->depth + 1) * sizeof(int);
+    }
+    if(t->branched != NULL) {
+        size += (t->depth + 1) * sizeof(int);
+    }
+    return size;
+}
+
+static void drop_task(parallel_pool* pool, parallel_task* t)
+{
+    budget_reserve(pool->c->budget, -task_sizeof(t));
+    task_free(t);
+}
+
+/* Leave a task unexplored when a limit stopped the search */
+static void leave_task(parallel_pool* pool, parallel_task* t)
+{
+    budget_open(pool->c->budget, t->bound, pool->c->maximize);
+    drop_task(pool, t);
+}
+
+/* Wake a worker waiting for a task, or all of them */
+static void wake_workers(parallel_pool* pool, bool all)
+{
+    g_mutex_lock(&pool->wait);
+    if(all) {
+        g_cond_broadcast(&pool->work);
+    } else {
+        g_cond_signal(&pool->work);
+    }
+    g_mutex_unlock(&pool->wait);
+}
+
+static void push_task(parallel_worker* w, parallel_task* t)
+{
+    budget_reserve(w->pool->c->budget, task_sizeof(t));
+    g_atomic_int_inc(&w->pool->pending);
+    g_mutex_lock(&w->lock);
+    g_queue_push_tail(w->tasks, t);
+    g_atomic_int_set(&w->queued, g_queue_get_length(w->tasks));
+    g_mutex_unlock(&w->lock);
+
+    /* A worker counts itself idle before it checks the deques and waits */
+    if(g_atomic_int_get(&w->pool->idle) > 0) {
+        wake_workers(w->pool, false);
+    }
+}
+
+static parallel_task* pop_task(parallel_worker* w, bool steal)
+{
+    /* Avoid the lock if there is nothing to take */
+    if(g_atomic_int_get(&w->queued) == 0) {
+        return NULL;
+    }
+
+    g_mutex_lock(&w->lock);
+    parallel_task* t = (parallel_task*) (steal ?
+                                g_queue_pop_head(w->tasks) :
+                                g_queue_pop_tail(w->tasks));
+    g_atomic_int_set(&w->queued, g_queue_get_length(w->tasks));
+    g_mutex_unlock(&w->lock);
+    return t;
+}
+
+static parallel_task* take_task(parallel_worker* w)
+{
+    parallel_task* t = pop_task(w, false);
+    if(t != NULL) {
+        return t;
+    }
+
+    /* Steal, starting after this worker so victims are spread */
+    parallel_pool* pool = w->pool;
+    for(int k = 1; k < pool->threads; k++) {
+        t = pop_task(&pool->workers[(w->id + k) % pool->threads], true);
+        if(t != NULL) {
+            return t;
+        }
+    }
+    return NULL;
+}
+
+static bool any_queued(parallel_pool* pool)
+{
+    for(int k = 0; k < pool->threads; k++) {
+        if(g_atomic_int_get(&pool->workers[k].queued) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void fix_task(parallel_worker* w, parallel_task* t, bool fix)
+{
+    for(int j = 0; j < w->pool->c->num_vars; j++) {
+        int value = assignment_get(t->fixed, j);
+        if(value == -1) {
+            continue;
+        }
+        if(fix) {
+            activity_fix(w->a, j, value);
+        } else {
+            activity_release(w->a, j);
+        }
+    }
+}
+
+static void run_task(parallel_worker* w, parallel_task* t)
+{
+    bip_context* c = w->pool->c;
+
+    /* Move the activity to the root of the subtree and back, the variable
+     * fixed last is not known */
+    fix_task(w, t, true);
+    if(t->depth > 0) {
+        w->stack[t->depth - 1].var = -1;
+    }
+    w->nodes += impl_search_parallel(c, w->a, w->pool->alpha, w->candidate,
+                                     NULL, NULL, NULL, NULL, w->stack,
+                                     t->depth, 1, c->num_vars + 1, w);
+    fix_task(w, t, false);
+}
+
+static gpointer worker_run(gpointer data)
+{
+    parallel_worker* w = (parallel_worker*) data;
+    parallel_pool* pool = w->pool;
+
+    while(true) {
+
+        parallel_task* t = take_task(w);
+
+        /* Nothing to do, finish when no task can be donated anymore or
+         * sleep until one is */
+        if(t == NULL) {
+            if(g_atomic_int_get(&pool->pending) == 0) {
+                break;
+            }
+            if(!w->idle) {
+                g_atomic_int_inc(&pool->idle);
+                w->idle = true;
+            }
+            g_mutex_lock(&pool->wait);
+            while((g_atomic_int_get(&pool->pending) > 0) &&
+                  !any_queued(pool)) {
+                g_cond_wait(&pool->work, &pool->wait);
+            }
+            g_mutex_unlock(&pool->wait);
+            continue;
+        }
+        if(w->idle) {
+            g_atomic_int_add(&pool->idle, -1);
+            w->idle = false;
+        }
+
+        if(budget_stopped(pool->c->budget)) {
+            leave_task(pool, t);
+        } else {
+            run_task(w, t);
+            drop_task(pool, t);
+        }
+        if(g_atomic_int_dec_and_test(&pool->pending)) {
+            wake_workers(pool, true);
+        }
+    }
+
+    return NULL;
+}
+
+static void worker_clear(parallel_worker* w)
+{
+    budget_reserve(w->pool->c->budget, -w->reserved);
+    if(w->tasks != NULL) {
+        g_queue_free_full(w->tasks, task_free);
+    }
+    g_mutex_clear(&w->lock);
+    activity_free(w->a);
+    assignment_free(w->candidate);
+    free(w->stack);
+    free(w->fixed);
+    free(w->workplace);
+    free(w->parents);
+    free(w->branched);
+}
+
+static bool worker_init(parallel_worker* w, parallel_pool* pool, int id)
+{
+    bip_context* c = pool->c;
+    int v = c->num_vars;
+
+    w->id = id;
+    w->pool = pool;
+    g_mutex_init(&w->lock);
+    w->tasks = g_queue_new();
+    w->queued = 0;
+    w->idle = false;
+    w->failed = false;
+    w->nodes = 0;
+    w->reserved = 0;
+    w->fixed = NULL;
+    w->workplace = NULL;
+    w->parents = NULL;
+    w->branched = NULL;
+
+    w->a = activity_new(c);
+    w->candidate = assignment_new(v);
+    w->stack = (impl_frame*) malloc((v + 1) * sizeof(impl_frame));
+    if((w->a == NULL) || (w->candidate == NULL) || (w->stack == NULL)) {
+        worker_clear(w);
+        return false;
+    }
+
+    if(c->trace && c->deterministic && (id == 0)) {
+        w->fixed = (int*) malloc(v * sizeof(int));
+        w->workplace = (int*) malloc(v * sizeof(int));
+        w->parents = (int*) malloc((v + 1) * sizeof(int));
+        w->branched = (int*) malloc((v + 1) * sizeof(int));
+        if((w->fixed == NULL) || (w->workplace == NULL) ||
+           (w->parents == NULL) || (w->branched == NULL)) {
+            worker_clear(w);
+            return false;
+        }
+        for(int i = 0; i < v; i++) {
+            w->workplace[i] = -1;
+            w->parents[i] = -1;
+            w->branched[i] = -1;
+        }
+        w->parents[v] = -1;
+        w->branched[v] = -1;
+    }
+
+    w->reserved = activity_sizeof(w->a) + assignment_sizeof(w->candidate) +
+                  ((v + 1) * sizeof(impl_frame));
+    budget_reserve(c->budget, w->reserved);
+    return true;
+}
+
+static bool better(bip_context* c, number value, number alpha)
+{
+    return c->maximize ? (value > alpha) : (value < alpha);
+}
+
+/* Explore a subtree of a round with the alpha of the start of the round, so
+ * the result doesn't depend on the other subtrees of the round */
+static void run_round_task(parallel_worker* w, parallel_task* t, long first)
+{
+    parallel_pool* pool = w->pool;
+    bip_context* c = pool->c;
+
+    /* Pseudo-costs and nogoods learnt in other subtrees would depend on the
+     * worker */
+    fix_task(w, t, true);
+    branch_forget(w->a);
+    if(w->a->learnt != NULL) {
+        nogood_forget(w->a->learnt);
+    }
+    if(t->depth > 0) {
+        w->stack[t->depth - 1].var = -1;
+    }
+    t->alpha = pool->epoch;
+    assignment_clear(t->best);
+    if(w->parents != NULL) {
+        memcpy(w->parents, t->parents, t->depth * sizeof(int));
+        memcpy(w->branched, t->branched, t->depth * sizeof(int));
+        t->nodes = impl_search_rounds_traced(c, w->a, &t->alpha, t->best,
+                                w->fixed, w->workplace, w->parents,
+                                w->branched, w->stack, t->depth, first,
+                                c->num_vars + 1, w);
+    } else {
+        t->nodes = impl_search_rounds(c, w->a, &t->alpha, t->best,
+                                NULL, NULL, NULL, NULL, w->stack,
+                                t->depth, first, c->num_vars + 1, w);
+    }
+    fix_task(w, t, false);
+}
+
+static gpointer round_run(gpointer data)
+{
+    parallel_worker* w = (parallel_worker*) data;
+    parallel_pool* pool = w->pool;
+
+    /* Any order gives the same results, take the next task. Its nodes are
+     * numbered from 1, the subtrees before it may not be finished. */
+    while(true) {
+        int k = g_atomic_int_add(&pool->next, 1);
+        if(k >= pool->round_size) {
+            break;
+        }
+        run_round_task(w, pool->round[k], 1);
+    }
+    return NULL;
+}
+
+/**
+ * Deterministic search.
+ *
+ * The first worker explores the tree down to a fixed depth, deferring the
+ * nodes found there as subtrees in depth first order. The subtrees are then
+ * explored in rounds of PARALLEL_ROUND per thread, all of them against the
+ * alpha of the start of the round (the epoch). At the end of each round the
+ * results are merged in subtree order. Nothing depends on the scheduling, so
+ * the candidate, the node count and the node numbers are the same in every
+ * run with the same number of threads.
+ *
+ * When tracing, the subtrees are explored one after the other on this thread
+ * so nodes are logged in that order, and the node numbers of a subtree follow
+ * the ones of the subtrees before it. The result is the same as in parallel.
+ * In parallel the size of the subtrees before one isn't known when it
+ * starts, so the nodes of each subtree are numbered from 1.
+ */
+static long deterministic_enumeration(parallel_pool* pool, number* alpha,
+                                      assignment* candidate)
+{
+    bip_context* c = pool->c;
+    parallel_worker* first = &pool->workers[0];
+
+    /* Frontier, about 2^PARALLEL_SPLIT subtrees per thread */
+    int levels = 0;
+    while((1 << levels) < pool->threads) {
+        levels++;
+    }
+    int split = min(c->num_vars, levels + PARALLEL_SPLIT);
+
+    long nodes = 0;
+    if(first->parents != NULL) {
+        nodes = impl_search_rounds_traced(c, first->a, alpha, candidate,
+                            first->fixed, first->workplace, first->parents,
+                            first->branched, first->stack, 0, 1, split,
+                            first);
+    } else {
+        nodes = impl_search_rounds(c, first->a, alpha, candidate,
+                            NULL, NULL, NULL, NULL, first->stack, 0, 1,
+                            split, first);
+    }
+    if(first->failed) {
+        return -1;
+    }
+
+    /* Rounds */
+    int size = pool->threads * PARALLEL_ROUND;
+    pool->round = (parallel_task**) malloc(size * sizeof(parallel_task*));
+    if(pool->round == NULL) {
+        return -1;
+    }
+    GThread** threads = (GThread**) g_malloc0(pool->threads * sizeof(GThread*));
+
+    bool success = true;
+    while(success && (first->queued > 0) && !budget_stopped(c->budget)) {
+
+        /* Take the next subtrees in order */
+        pool->round_size = 0;
+        while((pool->round_size < size) && (first->queued > 0)) {
+            parallel_task* t = pop_task(first, true);
+            pool->round[pool->round_size++] = t;
+            if(t->best == NULL) {
+                t->best = assignment_new(c->num_vars);
+                success = success && (t->best != NULL);
+            }
+        }
+        if(!success) {
+            break;
+        }
+        pool->next = 0;
+        pool->epoch = *alpha;
+
+        /* Explore them */
+        if(first->parents != NULL) {
+            for(int k = 0; k < pool->round_size; k++) {
+                run_round_task(first, pool->round[k], nodes + 1);
+                nodes += pool->round[k]->nodes;
+            }
+        } else {
+            for(int i = 1; i < pool->threads; i++) {
+                threads[i] = g_thread_try_new("bip-worker", round_run,
+                                              &pool->workers[i], NULL);
+            }
+            round_run(first);
+            for(int i = 1; i < pool->threads; i++) {
+                if(threads[i] != NULL) {
+                    g_thread_join(threads[i]);
+                }
+            }
+            for(int k = 0; k < pool->round_size; k++) {
+                nodes += pool->round[k]->nodes;
+            }
+        }
+
+        /* Merge in order, the first of equal subtrees wins */
+        for(int k = 0; k < pool->round_size; k++) {
+            parallel_task* t = pool->round[k];
+            if(better(c, t->alpha, *alpha)) {
+                *alpha = t->alpha;
+                assignment_copy(t->best, candidate);
+            }
+        }
+
+        for(int k = 0; k < pool->round_size; k++) {
+            drop_task(pool, pool->round[k]);
+        }
+        pool->round_size = 0;
+    }
+
+    for(int k = 0; k < pool->round_size; k++) {
+        drop_task(pool, pool->round[k]);
+    }
+
+    /* The subtrees of the rounds a limit cancelled are left open */
+    parallel_task* t = NULL;
+    while((t = pop_task(first, true)) != NULL) {
+        leave_task(pool, t);
+    }
+    g_free(threads);
+    free(pool->round);
+
+    return success ? nodes : -1;
+}
+
+int parallel_threads(bip_context* c)
+{
+    if(c->threads > 0) {
+        return c->threads;
+    }
+    return g_get_num_processors();
+}
+
+long parallel_enumeration(bip_context* c, number* alpha,
+                          assignment* candidate)
+{
+    parallel_pool pool;
+    pool.c = c;
+    pool.alpha = alpha;
+    pool.threads = parallel_threads(c);
+    pool.pending = 0;
+    pool.idle = 0;
+    pool.round = NULL;
+    pool.round_size = 0;
+    pool.next = 0;
+    pool.epoch = *alpha;
+
+    /* Try to allocate memory */
+    pool.workers = (parallel_worker*) malloc(pool.threads *
+                                             sizeof(parallel_worker));
+    if(pool.workers == NULL) {
+        return -1;
+    }
+    for(int i = 0; i < pool.threads; i++) {
+        if(!worker_init(&pool.workers[i], &pool, i)) {
+            for(int k = 0; k < i; k++) {
+                worker_clear(&pool.workers[k]);
+            }
+            free(pool.workers);
+            return -1;
+        }
+    }
+
+    if(c->deterministic) {
+        long nodes = deterministic_enumeration(&pool, alpha, candidate);
+        for(int i = 0; i < pool.threads; i++) {
+            stats_merge(&c->stats, &pool.workers[i].a->stats, 0, c->maximize);
+            worker_clear(&pool.workers[i]);
+        }
+        free(pool.workers);
+        return nodes;
+    }
+
+    /* The whole tree is the first task */
+    activity* a = pool.workers[0].a;
+    parallel_task* root = task_new(candidate, 0,
+                                   a->fixed_perf + a->free_perf);
+    if(root == NULL) {
+        for(int i = 0; i < pool.threads; i++) {
+            worker_clear(&pool.workers[i]);
+        }
+        free(pool.workers);
+        return -1;
+    }
+    assignment_clear(root->fixed);
+    g_mutex_init(&pool.wait);
+    g_cond_init(&pool.work);
+    push_task(&pool.workers[0], root);
+
+    /* Start the workers, this thread is the first one. If a thread can't be
+     * created its deque stays empty and the others do its share. */
+    GThread** threads = (GThread**) g_malloc0(pool.threads * sizeof(GThread*));
+    for(int i = 1; i < pool.threads; i++) {
+        threads[i] = g_thread_try_new("bip-worker", worker_run,
+                                      &pool.workers[i], NULL);
+    }
+    worker_run(&pool.workers[0]);
+    for(int i = 1; i < pool.threads; i++) {
+        if(threads[i] != NULL) {
+            g_thread_join(threads[i]);
+        }
+    }
+    g_free(threads);
+    g_cond_clear(&pool.work);
+    g_mutex_clear(&pool.wait);
+
+    /* Only the worker that stored the final alpha has it as candidate */
+    long nodes = 0;
+    for(int i = 0; i < pool.threads; i++) {
+        parallel_worker* w = &pool.workers[i];
+        nodes += w->nodes;
+        if((assignment_count(w->candidate) > 0) &&
+           (assignment_dot(w->candidate, c->function) == *alpha)) {
+            assignment_copy(w->candidate, candidate);
+        }
+        stats_merge(&c->stats, &w->a->stats, 0, c->maximize);
+        worker_clear(w);
+    }
+    free(pool.workers);
+
+    return nodes;
+}
+
+bool parallel_improve(number* alpha, number value, bool maximize)
+{
+    number current = parallel_alpha(alpha);
+    while((maximize && (value > current)) || (!maximize && (value < current))) {
+#if NUMBER_INT
+        if(g_atomic_int_compare_and_exchange(alpha, current, value)) {
+            return true;
+        }
+        current = g_atomic_int_get(alpha);
+#else
+        /* Reloads current if another worker changed it */
+        if(__atomic_compare_exchange(alpha, &current, &value, false,
+                                     __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+            return true;
+        }
+#endif
+    }
+    return false;
+}
+
+bool parallel_starving(parallel_worker* w, int free)
+{
+    return (free >= PARALLEL_CUTOFF) &&
+           (g_atomic_int_get(&w->pool->idle) > 0) &&
+           (g_atomic_int_get(&w->queued) == 0);
+}
+
+bool parallel_donate(parallel_worker* w, assignment* fixed, int var,
+                     int value, int depth, number bound)
+{
+    parallel_task* t = task_new(fixed, depth, bound);
+    if(t == NULL) {
+        return false;
+    }
+    assignment_set(t->fixed, var, value);
+    push_task(w, t);
+    return true;
+}
+
+void parallel_defer(parallel_worker* w, assignment* fixed, int depth,
+                    number bound, int* parents, int* branched)
+{
+    parallel_task* t = task_new(fixed, depth, bound);
+    if(t == NULL) {
+        w->failed = true;
+        return;
+    }
+    if(parents != NULL) {
+        t->parents = (int*) malloc((depth + 1) * sizeof(int));
+        if(t->parents == NULL) {
+            task_free(t);
+            w->failed = true;
+            return;
+        }
+        memcpy(t->parents, parents, depth * sizeof(int));
+    }
+    if(branched != NULL) {
+        t->branched = (int*) malloc((depth + 1) * sizeof(int));
+        if(t->branched == NULL) {
+            task_free(t);
+            w->failed = true;
+            return;
+        }
+        memcpy(t->branched, branched, depth * sizeof(int));
+    }
+    push_task(w, t);
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_PARALLEL
+#define H_PARALLEL
+
+#include "bip.h"
+#include "assignment.h"
+
+/* Subtrees with less free variables than this are not worth sharing */
+#define PARALLEL_CUTOFF 8
+
+/* Deterministic mode: depth of the subtrees, over log2 of the threads, and
+ * subtrees per thread in each round */
+#define PARALLEL_SPLIT 6
+#define PARALLEL_ROUND 4
+
+/**
+ * Worker of the parallel Implicit Enumeration.
+ *
+ * Each worker owns a running activity of the model and a deque of subtrees,
+ * given as the bit-packed assignment of the variables fixed at their root.
+ * A worker takes its newest subtree and, when it runs out of them, steals the
+ * oldest (and biggest) subtree of another worker. While some worker is idle,
+ * a worker with an empty deque donates the second branch of every node it
+ * expands instead of exploring it. Idle workers sleep until a subtree is
+ * donated or the search is over.
+ */
+typedef struct parallel_worker parallel_worker;
+
+/**
+ * Number of threads the search of the given context will use.
+ *
+ * @param c, the binary integer programming context data structure.
+ * @return 'threads' from the context or the number of processors if it is 0.
+ */
+int parallel_threads(bip_context* c);
+
+/**
+ * Perform the Implicit Enumeration with a pool of workers.
+ *
+ * If 'deterministic' is set in the context the subtrees are explored in
+ * rounds instead, which gives the same candidate, node numbers and trace in
+ * every run with the same number of threads.
+ *
+ * @param c, the binary integer programming context data structure.
+ * @param alpha, the performance of the candidate. Shared by all workers, who
+ *        prune against it as soon as any of them improves it.
+ * @param candidate, where to store the best solution found.
+ * @return the number of nodes evaluated or -1 if enough memory could not be
+ *         allocated.
+ */
+long parallel_enumeration(bip_context* c, number* alpha,
+                          assignment* candidate);
+
+/**
+ * Atomically improve a shared alpha.
+ *
+ * @param alpha, the shared alpha.
+ * @param value, the performance of a new candidate.
+ * @param maximize, the direction of the optimization.
+ * @return TRUE if 'value' was better and was stored or FALSE if another
+ *         worker already found a solution as good.
+ */
+bool parallel_improve(number* alpha, number value, bool maximize);
+
+/**
+ * Atomically read a shared alpha.
+ *
+ * @param alpha, the shared alpha.
+ * @return its current value.
+ */
+static inline number parallel_alpha(number* alpha)
+{
+#if NUMBER_INT
+    return g_atomic_int_get(alpha);
+#else
+    number value;
+    __atomic_load(alpha, &value, __ATOMIC_SEQ_CST);
+    return value;
+#endif
+}
+
+/**
+ * Check if a worker should donate work.
+ *
+ * @param w, the worker.
+ * @param free, the number of free variables of the subtree to donate.
+ * @return TRUE if some worker is idle, the deque of this one is empty and
+ *         the subtree is big enough.
+ */
+bool parallel_starving(parallel_worker* w, int free);
+
+/**
+ * Donate a subtree to the deque of a worker.
+ *
+ * @param w, the worker.
+ * @param fixed, the variables fixed at the current node.
+ * @param var, value, the branch to donate.
+ * @param depth, the depth of the root of the subtree.
+ * @param bound, the best fit of the current node, a bound of the subtree.
+ * @return TRUE if the subtree was donated or FALSE if enough memory could
+ *         not be allocated, in which case the worker must explore it.
+ */
+bool parallel_donate(parallel_worker* w, assignment* fixed, int var,
+                     int value, int depth, number bound);
+
+/**
+ * Defer a subtree to a later round of the deterministic search.
+ *
+ * @param w, the worker.
+ * @param fixed, the variables fixed at the root of the subtree.
+ * @param depth, the depth of the root of the subtree.
+ * @param bound, a bound of the subtree, left to the budget if a limit
+ *        stops the search before it is explored.
+ * @param parents, the node numbers of the path to the root, NULL if not
+ *        tracing.
+ * @param branched, the variables branched on along that path, NULL if not
+ *        tracing.
+ * @return nothing, 'failed' is set in the worker if enough memory could not
+ *         be allocated.
+ */
+void parallel_defer(parallel_worker* w, assignment* fixed, int depth,
+                    number bound, int* parents, int* branched);
+
+#endif
@@ -0,0 +1,377 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "presolve.h"
+
+/* Working copy of the restrictions, by rows */
+typedef struct {
+    int num_vars;
+    int num_rest;
+    int* start;
+    int* column;
+    number* value;
+    int* type;
+    number* equl;
+    bool* active;
+    int* fixed;     /* Value of each variable, -1 if free */
+    int* count;     /* Nonzeros of each column in active restrictions */
+} workset;
+
+static void workset_free(workset* w)
+{
+    free(w->start);
+    free(w->column);
+    free(w->value);
+    free(w->type);
+    free(w->equl);
+    free(w->active);
+    free(w->fixed);
+    free(w->count);
+}
+
+static bool workset_init(workset* w, bip_context* c)
+{
+    int n = c->num_vars;
+    int m = c->num_rest;
+
+    /* Walk the restrictions by rows, index the dense ones if needed */
+    sparse* s = c->sparse_rests;
+    if(s == NULL) {
+        s = (m > 0) ? sparse_from_matrix(c->restrictions, n) :
+                      sparse_new(0, n, 0);
+        if(s == NULL) {
+            return false;
+        }
+    }
+
+    w->num_vars = n;
+    w->num_rest = m;
+    w->start  = (int*) malloc((m + 1) * sizeof(int));
+    w->column = (int*) malloc((s->nnz + 1) * sizeof(int));
+    w->value  = (number*) malloc((s->nnz + 1) * sizeof(number));
+    w->type   = (int*) malloc((m + 1) * sizeof(int));
+    w->equl   = (number*) malloc((m + 1) * sizeof(number));
+    w->active = (bool*) malloc((m + 1) * sizeof(bool));
+    w->fixed  = (int*) malloc(n * sizeof(int));
+    w->count  = (int*) malloc(n * sizeof(int));
+    bool success = (w->start != NULL) && (w->column != NULL) &&
+                   (w->value != NULL) && (w->type != NULL) &&
+                   (w->equl != NULL) && (w->active != NULL) &&
+                   (w->fixed != NULL) && (w->count != NULL);
+
+    /* Copy the restrictions, as LE or EQ */
+    for(int i = 0; success && (i < m); i++) {
+        int sign = (rest_type(c, i) == GE) ? -1 : 1;
+        w->start[i] = s->row_start[i];
+        for(int k = s->row_start[i]; k < s->row_start[i + 1]; k++) {
+            w->column[k] = s->row_column[k];
+            w->value[k] = sign * s->row_value[k];
+        }
+        w->type[i] = (rest_type(c, i) == EQ) ? EQ : LE;
+        w->equl[i] = sign * rest_equl(c, i);
+        w->active[i] = true;
+    }
+    if(success) {
+        w->start[m] = s->nnz;
+        for(int j = 0; j < n; j++) {
+            w->fixed[j] = -1;
+        }
+    }
+
+    if(s != c->sparse_rests) {
+        sparse_free(s);
+    }
+    if(!success) {
+        workset_free(w);
+    }
+    return success;
+}
+
+static void push_step(presolved* p, enum PostsolveOp op, int var, int value)
+{
+    p->stack[p->size].op = op;
+    p->stack[p->size].var = var;
+    p->stack[p->size].value = value;
+    p->size++;
+}
+
+/* Fix a variable, the model is not factible if it was fixed the other way */
+static void fix(presolved* p, workset* w, int var, int value, bool* changed)
+{
+    if(w->fixed[var] == -1) {
+        w->fixed[var] = value;
+        push_step(p, post_forced, var, value);
+        *changed = true;
+    } else if(w->fixed[var] != value) {
+        p->infeasible = true;
+    }
+}
+
+/* Reduce a restriction, returns TRUE if something changed */
+static bool reduce(presolved* p, workset* w, int i)
+{
+    /* Activity of the free variables and equality left for them */
+    number rhs = w->equl[i];
+    number bottom = 0;
+    number top = 0;
+    for(int k = w->start[i]; k < w->start[i + 1]; k++) {
+        number coeff = w->value[k];
+        int n = w->fixed[w->column[k]];
+        if(n != -1) {
+            rhs -= coeff * n;
+        } else if(coeff > 0) {
+            top += coeff;
+        } else {
+            bottom += coeff;
+        }
+    }
+    bool eq = (w->type[i] == EQ);
+
+    /* Factibility */
+    if((bottom > rhs) || (eq && (top < rhs))) {
+        p->infeasible = true;
+        return false;
+    }
+
+    /* Redundancy */
+    if((!eq && (top <= rhs)) || (eq && (top == bottom))) {
+        w->active[i] = false;
+        p->removed_rests++;
+        return true;
+    }
+
+    /* Forced variables. Fixing them doesn't change the side of the activity
+     * that forced them, so all are found with the same margins. */
+    bool changed = false;
+    for(int k = w->start[i]; k < w->start[i + 1]; k++) {
+        int var = w->column[k];
+        number coeff = w->value[k];
+        if(w->fixed[var] != -1) {
+            continue;
+        }
+        if((coeff > 0) && (bottom + coeff > rhs)) {
+            fix(p, w, var, 0, &changed);
+        } else if((coeff < 0) && (bottom - coeff > rhs)) {
+            fix(p, w, var, 1, &changed);
+        }
+        if(eq && (coeff > 0) && (top - coeff < rhs)) {
+            fix(p, w, var, 1, &changed);
+        } else if(eq && (coeff < 0) && (top + coeff < rhs)) {
+            fix(p, w, var, 0, &changed);
+        }
+    }
+    if(changed || eq) {
+        return changed;
+    }
+
+    /* Coefficient tightening: if a variable alone can make the restriction
+     * redundant, lower its coefficient to where it just does */
+    for(int k = w->start[i]; k < w->start[i + 1]; k++) {
+        number coeff = w->value[k];
+        if(w->fixed[w->column[k]] != -1) {
+            continue;
+        }
+        if((coeff > 0) && (top - coeff < rhs)) {
+            number delta = rhs - (top - coeff);
+            w->value[k] -= delta;
+            w->equl[i] -= delta;
+            rhs -= delta;
+            top -= delta;
+            changed = true;
+        } else if((coeff < 0) && (top + coeff < rhs)) {
+            w->value[k] += rhs - (top + coeff);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+/* Set the columns left without coefficients to their best fit */
+static bool drop_columns(presolved* p, workset* w, bip_context* c)
+{
+    for(int j = 0; j < w->num_vars; j++) {
+        w->count[j] = 0;
+    }
+    for(int i = 0; i < w->num_rest; i++) {
+        if(!w->active[i]) {
+            continue;
+        }
+        for(int k = w->start[i]; k < w->start[i + 1]; k++) {
+            w->count[w->column[k]]++;
+        }
+    }
+
+    bool changed = false;
+    for(int j = 0; j < w->num_vars; j++) {
+        if((w->fixed[j] != -1) || (w->count[j] > 0)) {
+            continue;
+        }
+        number coeff = c->function[j];
+        int value = 0;
+        if(coeff != 0) {
+            value = ((coeff > 0) == c->maximize) ? 1 : 0;
+        }
+        w->fixed[j] = value;
+        push_step(p, post_dropped, j, value);
+        changed = true;
+    }
+    return changed;
+}
+
+/* Build the model with the free variables and the active restrictions */
+static bool build_reduced(presolved* p, workset* w, bip_context* c)
+{
+    int n = w->num_vars;
+    int m = w->num_rest;
+
+    p->offset = 0;
+    int free_vars = 0;
+    for(int j = 0; j < n; j++) {
+        if(w->fixed[j] == -1) {
+            p->map[free_vars++] = j;
+        } else {
+            p->offset += c->function[j] * w->fixed[j];
+        }
+    }
+    if(free_vars == 0) {
+        return true;
+    }
+
+    /* Reuse the working arrays, active restrictions are compacted in place
+     * and the columns renumbered */
+    for(int k = 0; k < free_vars; k++) {
+        w->count[p->map[k]] = k;
+    }
+    int rests = 0;
+    int nnz = 0;
+    for(int i = 0; i < m; i++) {
+        if(!w->active[i]) {
+            continue;
+        }
+        number rhs = w->equl[i];
+        int first = nnz;
+        for(int k = w->start[i]; k < w->start[i + 1]; k++) {
+            int var = w->column[k];
+            if(w->fixed[var] != -1) {
+                rhs -= w->value[k] * w->fixed[var];
+                continue;
+            }
+            w->column[nnz] = w->count[var];
+            w->value[nnz] = w->value[k];
+            nnz++;
+        }
+        w->start[rests] = first;
+        w->type[rests] = w->type[i];
+        w->equl[rests] = rhs;
+        rests++;
+    }
+    w->start[rests] = nnz;
+
+    p->reduced = bip_context_from_rows(free_vars, rests, w->start, w->column,
+                                       w->value, w->type, w->equl);
+    if(p->reduced == NULL) {
+        return false;
+    }
+    p->reduced->maximize = c->maximize;
+    for(int k = 0; k < free_vars; k++) {
+        p->reduced->function[k] = c->function[p->map[k]];
+    }
+    return true;
+}
+
+presolved* presolve_new(bip_context* c)
+{
+    int n = c->num_vars;
+
+    /* Allocate structure */
+    presolved* p = (presolved*) malloc(sizeof(presolved));
+    if(p == NULL) {
+        return NULL;
+    }
+    p->num_vars = n;
+    p->infeasible = false;
+    p->reduced = NULL;
+    p->offset = 0;
+    p->removed_rests = 0;
+    p->size = 0;
+
+    /* A variable is fixed at most once */
+    p->map = (int*) malloc(n * sizeof(int));
+    p->stack = (postsolve_step*) malloc(n * sizeof(postsolve_step));
+    if((p->map == NULL) || (p->stack == NULL)) {
+        presolve_free(p);
+        return NULL;
+    }
+
+    workset w;
+    if(!workset_init(&w, c)) {
+        presolve_free(p);
+        return NULL;
+    }
+
+    /* Reduce until nothing changes */
+    bool changed = true;
+    while(changed && !p->infeasible) {
+        changed = false;
+        for(int i = 0; (i < w.num_rest) && !p->infeasible; i++) {
+            if(w.active[i] && reduce(p, &w, i)) {
+                changed = true;
+            }
+        }
+        if(!p->infeasible && drop_columns(p, &w, c)) {
+            changed = true;
+        }
+    }
+    DEBUG("Presolve: %i variables fixed, %i restrictions removed.\n",
+          p->size, p->removed_rests);
+
+    if(!p->infeasible && !build_reduced(p, &w, c)) {
+        workset_free(&w);
+        presolve_free(p);
+        return NULL;
+    }
+
+    workset_free(&w);
+    return p;
+}
+
+void presolve_restore(presolved* p, int* vars, int* candidate)
+{
+    if(vars != NULL) {
+        for(int k = 0; k < p->reduced->num_vars; k++) {
+            candidate[p->map[k]] = vars[k];
+        }
+    }
+
+    for(int s = p->size - 1; s >= 0; s--) {
+        candidate[p->stack[s].var] = p->stack[s].value;
+    }
+}
+
+void presolve_free(presolved* p)
+{
+    if(p == NULL) {
+        return;
+    }
+    if(p->reduced != NULL) {
+        bip_context_free(p->reduced);
+    }
+    free(p->map);
+    free(p->stack);
+    free(p);
+}
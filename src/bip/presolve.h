@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_PRESOLVE
+#define H_PRESOLVE
+
+#include "bip.h"
+
+/* Operations of the postsolve stack */
+enum PostsolveOp {
+    post_forced,    /* Fixed by a restriction */
+    post_dropped    /* Column without coefficients, set to its best fit */
+};
+
+typedef struct {
+    enum PostsolveOp op;
+    int var;
+    int value;
+} postsolve_step;
+
+/**
+ * Result of the presolve of a model.
+ *
+ * Until no more reductions are found, presolve repeats:
+ *
+ *     - Restrictions whose activity satisfies them for any value of the free
+ *       variables are removed.
+ *     - Free variables whose value is forced by a restriction are fixed,
+ *       which covers singleton restrictions.
+ *     - The model is found not factible if a restriction can't be satisfied.
+ *     - Coefficients of inequalities are tightened, so the relaxation of the
+ *       restriction is tighter but its binary solutions are the same.
+ *     - Columns without coefficients left are set to their best fit.
+ *
+ * Every fixed variable is pushed to the postsolve stack and the free ones
+ * form the reduced model, whose candidate is mapped back with
+ * presolve_restore(). Restrictions of type GE are stored as LE.
+ */
+typedef struct {
+
+    int num_vars;           /* Of the original model */
+    bool infeasible;
+
+    /* Reduced model, NULL if infeasible or if no free variables are left */
+    bip_context* reduced;
+    int* map;               /* Original index of each reduced variable */
+    number offset;          /* Performance of the fixed variables */
+    int removed_rests;
+
+    /* Postsolve stack */
+    postsolve_step* stack;
+    int size;
+
+} presolved;
+
+/**
+ * Presolve a model.
+ *
+ * @param c, the binary integer programming context data structure.
+ * @return a pointer to the presolve structure or NULL if enough memory could
+ *         not be allocated.
+ */
+presolved* presolve_new(bip_context* c);
+
+/**
+ * Map a solution of the reduced model to the original variables, unwinding
+ * the postsolve stack.
+ *
+ * @param p, the presolve structure (by reference)
+ * @param vars, the solution of the reduced model, NULL if it has no
+ *        variables.
+ * @param candidate, the destination vector with the original variables.
+ * @return nothing
+ */
+void presolve_restore(presolved* p, int* vars, int* candidate);
+
+/**
+ * Free resources associated with a presolve structure, including the reduced
+ * model.
+ *
+ * @return nothing
+ * @param p, the presolve structure (by reference)
+ */
+void presolve_free(presolved* p);
+
+#endif
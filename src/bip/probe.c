@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* clock_gettime() */
+#define _POSIX_C_SOURCE 199309L
+
+#include "probe.h"
+
+#if defined(PROBES)
+
+#include <time.h>
+
+/* Event recorded */
+typedef struct {
+    gint64 time;        /* Nanoseconds, monotonic */
+    int kind;           /* enum ProbeEvent */
+    long node;
+    int depth;
+} probe_entry;
+
+/* Ring of the events of a thread */
+typedef struct probe_ring {
+    probe_entry events[PROBE_CAPACITY];
+    guint64 head;               /* Events recorded, atomic */
+    int owned;                  /* Taken by a thread, atomic */
+    int id;                     /* Lane in the trace */
+    struct probe_ring* next;
+} probe_ring;
+
+/* Every ring, newest first. Rings are never freed, only given back. */
+static probe_ring* rings = NULL;
+static int ring_count = 0;
+
+/* Time of the last reset */
+static gint64 base = 0;
+
+static void give_back(gpointer data)
+{
+    probe_ring* r = (probe_ring*) data;
+    g_atomic_int_set(&r->owned, 0);
+}
+
+/* Ring of the calling thread, given back when the thread ends */
+static GPrivate ring_key = G_PRIVATE_INIT(give_back);
+
+static gint64 probe_now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return ((gint64) t.tv_sec * 1000000000) + t.tv_nsec;
+}
+
+/**
+ * Take a ring given back by a thread that ended, or add a new one.
+ *
+ * @return the ring or NULL if enough memory could not be allocated.
+ */
+static probe_ring* take_ring(void)
+{
+    probe_ring* r = (probe_ring*) g_atomic_pointer_get(&rings);
+    for(; r != NULL; r = r->next) {
+        if(g_atomic_int_compare_and_exchange(&r->owned, 0, 1)) {
+            return r;
+        }
+    }
+
+    r = (probe_ring*) malloc(sizeof(probe_ring));
+    if(r == NULL) {
+        return NULL;
+    }
+    r->head = 0;
+    r->owned = 1;
+    r->id = g_atomic_int_add(&ring_count, 1);
+    do {
+        r->next = (probe_ring*) g_atomic_pointer_get(&rings);
+    } while(!g_atomic_pointer_compare_and_exchange(&rings, r->next, r));
+    return r;
+}
+
+void probe_record(enum ProbeEvent kind, long node, int depth)
+{
+    probe_ring* r = (probe_ring*) g_private_get(&ring_key);
+    if(r == NULL) {
+        r = take_ring();
+        if(r == NULL) {
+            return;
+        }
+        g_private_set(&ring_key, r);
+    }
+
+    /* Only this thread writes the ring, the head publishes the event */
+    guint64 h = r->head;
+    probe_entry* e = &r->events[h & (PROBE_CAPACITY - 1)];
+    e->time = probe_now();
+    e->kind = kind;
+    e->node = node;
+    e->depth = depth;
+    __atomic_store_n(&r->head, h + 1, __ATOMIC_RELEASE);
+}
+
+void probe_reset(void)
+{
+    probe_ring* r = (probe_ring*) g_atomic_pointer_get(&rings);
+    for(; r != NULL; r = r->next) {
+        __atomic_store_n(&r->head, 0, __ATOMIC_RELEASE);
+    }
+    base = probe_now();
+}
+
+bool probe_export(const char* filename)
+{
+    const char* names[] = {"open", "prune", "candidate", "expand"};
+
+    FILE* file = fopen(filename, "w");
+    if(file == NULL) {
+        return false;
+    }
+
+    fprintf(file, "{\"traceEvents\": [\n");
+    bool first = true;
+    probe_ring* r = (probe_ring*) g_atomic_pointer_get(&rings);
+    for(; r != NULL; r = r->next) {
+        fprintf(file, "%s{\"name\": \"thread_name\", \"ph\": \"M\", "
+                "\"pid\": 1, \"tid\": %i, \"args\": {\"name\": \"search "
+                "%i\"}}", first ? "" : ",\n", r->id, r->id);
+        first = false;
+
+        /* A slice from each open to the event that closes the node, nodes
+         * whose open was overwritten are left out */
+        guint64 head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+        guint64 from = (head > PROBE_CAPACITY) ? head - PROBE_CAPACITY : 0;
+        probe_entry* open = NULL;
+        for(guint64 k = from; k < head; k++) {
+            probe_entry* e = &r->events[k & (PROBE_CAPACITY - 1)];
+            if(e->kind == probe_open) {
+                open = e;
+                continue;
+            }
+            if((open == NULL) || (open->node != e->node)) {
+                open = NULL;
+                continue;
+            }
+
+            fprintf(file, ",\n{\"name\": \"%s\", \"cat\": \"node\", "
+                    "\"ph\": \"X\", \"pid\": 1, \"tid\": %i, \"ts\": %.3lf, "
+                    "\"dur\": %.3lf, \"args\": {\"node\": %li, \"depth\": "
+                    "%i}}", names[e->kind], r->id,
+                    (open->time - base) / 1000.0,
+                    (e->time - open->time) / 1000.0, e->node, e->depth);
+            if(e->kind == probe_candidate) {
+                fprintf(file, ",\n{\"name\": \"candidate\", \"cat\": "
+                        "\"node\", \"ph\": \"i\", \"s\": \"g\", \"pid\": 1, "
+                        "\"tid\": %i, \"ts\": %.3lf}", r->id,
+                        (e->time - base) / 1000.0);
+            }
+            open = NULL;
+        }
+    }
+    fprintf(file, "\n], \"displayTimeUnit\": \"ns\"}\n");
+
+    bool success = ferror(file) == 0;
+    return (fclose(file) == 0) && success;
+}
+
+#endif
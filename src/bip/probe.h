@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_PROBE
+#define H_PROBE
+
+#include "utils.h"
+
+/* Events kept per thread, a power of 2. Older ones are overwritten. */
+#define PROBE_CAPACITY 65536
+
+/* Probe points of the search */
+enum ProbeEvent {
+    probe_open,         /* A node starts to be evaluated */
+    probe_prune,        /* It is closed without a better solution */
+    probe_candidate,    /* It is closed with a new candidate solution */
+    probe_expand        /* It is branched on */
+};
+
+/**
+ * Probes of the search, only built with -DPROBES.
+ *
+ * Each thread records its events in a ring buffer of its own, with a
+ * monotonic timestamp in nanoseconds, so recording takes no lock and no
+ * stdio. A thread takes a free ring the first time it records and gives it
+ * back when it ends, so the workers of later resolutions reuse the rings.
+ * The rings can be exported, once the threads writing them are done, as a
+ * Chrome trace (chrome://tracing, Perfetto) with one lane per ring and a
+ * slice per node evaluated.
+ *
+ * Without -DPROBES the probes and the rest of the calls below expand to
+ * nothing, and probe_export() to FALSE.
+ */
+#if defined(PROBES)
+
+#define PROBE(kind, node, depth) probe_record((kind), (node), (depth))
+
+/**
+ * Record an event on the ring of the calling thread.
+ *
+ * @param kind, the probe point.
+ * @param node, the number of the node.
+ * @param depth, the depth of the node in the stack of its search.
+ * @return nothing
+ */
+void probe_record(enum ProbeEvent kind, long node, int depth);
+
+/**
+ * Drop the events recorded, and take the time of the next ones from now.
+ *
+ * @return nothing
+ */
+void probe_reset(void);
+
+/**
+ * Write the events recorded as a Chrome trace. No thread can be recording.
+ *
+ * @param filename, the path of the JSON file to write.
+ * @return TRUE if the trace was written.
+ */
+bool probe_export(const char* filename);
+
+#else
+
+#define PROBE(kind, node, depth) ((void) 0)
+#define probe_reset() ((void) 0)
+#define probe_export(filename) false
+
+#endif
+
+#endif
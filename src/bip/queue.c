@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "queue.h"
+
+static bool before(queue_entry* x, queue_entry* y)
+{
+    return x->key < y->key;
+}
+
+static void swap(queue_entry* x, queue_entry* y)
+{
+    queue_entry t = *x;
+    *x = *y;
+    *y = t;
+}
+
+static void sift_up(node_queue* q, int k)
+{
+    while(k > 0) {
+        int parent = (k - 1) / 2;
+        if(!before(&q->heap[k], &q->heap[parent])) {
+            break;
+        }
+        swap(&q->heap[k], &q->heap[parent]);
+        k = parent;
+    }
+}
+
+static void sift_down(node_queue* q, int k)
+{
+    while(true) {
+        int child = (2 * k) + 1;
+        if(child >= q->size) {
+            break;
+        }
+        if((child + 1 < q->size) && before(&q->heap[child + 1],
+                                           &q->heap[child])) {
+            child++;
+        }
+        if(!before(&q->heap[child], &q->heap[k])) {
+            break;
+        }
+        swap(&q->heap[k], &q->heap[child]);
+        k = child;
+    }
+}
+
+/* Double the capacity, up to the limit. FALSE if already there. */
+static bool grow(node_queue* q)
+{
+    int capacity = (q->capacity == 0) ? QUEUE_INITIAL : 2 * q->capacity;
+    if(capacity > q->limit) {
+        capacity = q->limit;
+    }
+    if(capacity <= q->capacity) {
+        return false;
+    }
+
+    queue_entry* heap = (queue_entry*) realloc(q->heap,
+                                        capacity * sizeof(queue_entry));
+    if(heap == NULL) {
+        q->limit = q->capacity;
+        return false;
+    }
+    q->heap = heap;
+
+    int* free_slots = (int*) realloc(q->free_slots, capacity * sizeof(int));
+    if(free_slots == NULL) {
+        q->limit = q->capacity;
+        return false;
+    }
+    q->free_slots = free_slots;
+
+    uint64_t* slots = (uint64_t*) realloc(q->slots,
+                        (size_t) capacity * 2 * q->words * sizeof(uint64_t));
+    if(slots == NULL) {
+        q->limit = q->capacity;
+        return false;
+    }
+    q->slots = slots;
+
+    /* New slots are free, the ones in use are all before them */
+    for(int s = q->capacity; s < capacity; s++) {
+        q->free_slots[s - q->size] = s;
+    }
+    q->capacity = capacity;
+    return true;
+}
+
+node_queue* queue_new(bip_context* c)
+{
+    /* Allocate structure */
+    node_queue* q = (node_queue*) malloc(sizeof(node_queue));
+    if(q == NULL) {
+        return NULL;
+    }
+    q->num_vars = c->num_vars;
+    q->words = ASSIGNMENT_WORDS(c->num_vars);
+    q->maximize = c->maximize;
+    q->selection = c->selection;
+    q->heap = NULL;
+    q->size = 0;
+    q->slots = NULL;
+    q->free_slots = NULL;
+    q->capacity = 0;
+
+    size_t node = sizeof(queue_entry) + sizeof(int) +
+                  (2 * q->words * sizeof(uint64_t));
+    size_t limit = c->queue_memory / node;
+    if(limit < 1) {
+        limit = 1;
+    } else if(limit > INT_MAX / 2) {
+        limit = INT_MAX / 2;
+    }
+    q->limit = (int) limit;
+
+    q->node = assignment_new(c->num_vars);
+    if(q->node == NULL) {
+        queue_free(q);
+        return NULL;
+    }
+    return q;
+}
+
+bool queue_push(node_queue* q, activity* a, int var, number bf)
+{
+    if((q->size == q->capacity) && !grow(q)) {
+        return false;
+    }
+
+    /* Smaller keys first, so minimize the best fit */
+    queue_entry* e = &q->heap[q->size];
+    e->bound = a->fixed_perf + a->free_perf;
+    e->var = var;
+    e->bf = bf;
+    e->key = q->maximize ? -e->bound : e->bound;
+    if((q->selection == select_estimate) && (a->observations > 0)) {
+        e->key += a->violated * (a->pseudo_total / a->observations);
+    }
+
+    /* Store the variables */
+    e->slot = q->free_slots[q->capacity - q->size - 1];
+    uint64_t* slot = q->slots + ((size_t) e->slot * 2 * q->words);
+    memcpy(slot, a->fixed->mask, q->words * sizeof(uint64_t));
+    memcpy(slot + q->words, a->fixed->value, q->words * sizeof(uint64_t));
+
+    q->size++;
+    sift_up(q, q->size - 1);
+    return true;
+}
+
+bool queue_pop(node_queue* q, activity* a, queue_entry* e)
+{
+    if(q->size == 0) {
+        return false;
+    }
+    *e = q->heap[0];
+    q->size--;
+    if(q->size > 0) {
+        q->heap[0] = q->heap[q->size];
+        sift_down(q, 0);
+    }
+
+    /* Move to the node and free its slot */
+    uint64_t* slot = q->slots + ((size_t) e->slot * 2 * q->words);
+    memcpy(q->node->mask, slot, q->words * sizeof(uint64_t));
+    memcpy(q->node->value, slot + q->words, q->words * sizeof(uint64_t));
+    q->free_slots[q->capacity - q->size - 1] = e->slot;
+    activity_move(a, q->node);
+    return true;
+}
+
+void queue_clear(node_queue* q)
+{
+    while(q->size > 0) {
+        q->size--;
+        q->free_slots[q->capacity - q->size - 1] = q->heap[q->size].slot;
+    }
+}
+
+unsigned int queue_sizeof(node_queue* q)
+{
+    if(q == NULL) {
+        return 0;
+    }
+    return sizeof(node_queue) +
+           (q->capacity * (sizeof(queue_entry) + sizeof(int))) +
+           ((size_t) q->capacity * 2 * q->words * sizeof(uint64_t)) +
+           assignment_sizeof(q->node);
+}
+
+void queue_free(node_queue* q)
+{
+    if(q == NULL) {
+        return;
+    }
+    free(q->heap);
+    free(q->slots);
+    free(q->free_slots);
+    assignment_free(q->node);
+    free(q);
+}
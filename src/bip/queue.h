@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_QUEUE
+#define H_QUEUE
+
+#include "bip.h"
+#include "assignment.h"
+#include "activity.h"
+
+/* Default memory for the open nodes, 64 MiB */
+#define QUEUE_MEMORY 67108864
+
+/* Levels explored depth first below each node taken in the hybrid
+ * selection before going back to the best bound */
+#define QUEUE_PLUNGE 8
+
+/* Nodes allocated at first, the queue doubles from there up to its limit */
+#define QUEUE_INITIAL 64
+
+/* Open node, its variables are kept apart in a slot of the queue */
+typedef struct {
+    double key;     /* Nodes with smaller keys are explored first */
+    number bound;   /* Best fit of the node, before propagating */
+    int var;        /* Variable fixed last */
+    number bf;      /* Best fit of the parent, for the pseudo-costs */
+    int slot;
+} queue_entry;
+
+/**
+ * Priority queue of the open nodes of the best first searches.
+ *
+ * A binary heap of entries ordered by the key of the node selection of the
+ * context: the best fit for select_bound and select_hybrid, and for
+ * select_estimate the best fit degraded by the average pseudo-cost for each
+ * restriction the best fit violates. The fixed variables of each node are
+ * stored bit-packed, so a node takes 2 * ceil(num_vars / 64) words plus its
+ * entry. The queue grows up to 'queue_memory' bytes, then refuses new nodes
+ * and the search explores them depth first instead.
+ */
+typedef struct {
+
+    int num_vars;
+    int words;
+    bool maximize;
+    enum NodeSelection selection;
+
+    /* Heap */
+    queue_entry* heap;
+    int size;
+
+    /* Slots, mask and value words of each node */
+    uint64_t* slots;
+    int* free_slots;
+    int capacity;
+    int limit;      /* Most nodes that fit in the memory allowed */
+
+    assignment* node;   /* Scratch to move the activity to a node */
+
+} node_queue;
+
+/**
+ * Create an empty queue of open nodes.
+ *
+ * @param c, the binary integer programming context data structure.
+ * @return a pointer to the queue or NULL if enough memory could not be
+ *         allocated.
+ */
+node_queue* queue_new(bip_context* c);
+
+/**
+ * Store the node at the current state of the activity.
+ *
+ * @param q, the queue (by reference)
+ * @param a, the activity structure at the node (by reference)
+ * @param var, the variable fixed last.
+ * @param bf, the best fit of the parent of the node.
+ * @return FALSE if the queue is full, in which case the node wasn't stored.
+ */
+bool queue_push(node_queue* q, activity* a, int var, number bf);
+
+/**
+ * Take the node with the smallest key, moving the activity to it.
+ *
+ * @param q, the queue (by reference)
+ * @param a, the activity structure (by reference), with nothing on the
+ *        propagation trail.
+ * @param e, where to store the entry of the node.
+ * @return FALSE if the queue is empty.
+ */
+bool queue_pop(node_queue* q, activity* a, queue_entry* e);
+
+/**
+ * Drop every node in the queue.
+ *
+ * @param q, the queue (by reference)
+ * @return nothing
+ */
+void queue_clear(node_queue* q);
+
+/**
+ * Calculates the memory required by the queue.
+ *
+ * @return the size of the queue in bytes.
+ * @param q, the queue (by reference)
+ */
+unsigned int queue_sizeof(node_queue* q);
+
+/**
+ * Free resources associated with a queue.
+ *
+ * @return nothing
+ * @param q, the queue (by reference)
+ */
+void queue_free(node_queue* q);
+
+#endif
@@ -21,6 +21,8 @@
 
 bool implicit_report(bip_context* c)
 {
+    gint64 start = g_get_monotonic_time();
+
     /* Create report file */
     FILE* report = fopen("reports/implicit.tex", "w");
     if(report == NULL) {
@@ -59,6 +61,19 @@ bool implicit_report(bip_context* c)
     fprintf(report, "\\item %s : \\textsc{%i %s}. \n",
                     "Memory required", c->memory_required,
                     "bytes");
+    fprintf(report, "\\item %s : \\textsc{%lu %s}. \n",
+                    "Peak memory", c->stats.peak_memory,
+                    "bytes");
+    if(c->stopped != stop_none) {
+        const char* limits[] = {"", "the node limit", "the time limit",
+                                "the memory limit", "cancellation"};
+        fprintf(report, "\\item %s : \\textsc{%s}. \n",
+                        "Search stopped by", limits[c->stopped]);
+        fprintf(report, "\\item %s : \\textsc{" NUMBER_FORMAT "}. \n",
+                        "Bound of the optimum", c->bound);
+        fprintf(report, "\\item %s : \\textsc{%lf}. \n",
+                        "Relative gap", c->gap);
+    }
     fprintf(report, "\\end{compactitem}\n");
     fprintf(report, "\n");
 
@@ -98,9 +113,41 @@ bool implicit_report(bip_context* c)
     }
     c->report_buffer = report;
 
+    c->stats.phases[phase_report] += (g_get_monotonic_time() - start) / 1e6;
     return true;
 }
 
+bool implicit_statistics(bip_context* c, FILE* file)
+{
+    const char* stops[] = {"none", "nodes", "time", "memory", "cancel"};
+    bool found = c->candidate[0] != -1;
+
+    fprintf(file, "{\n");
+    fprintf(file, "    \"execution_time\": %lf,\n", c->execution_time);
+    fprintf(file, "    \"nodes\": %ld,\n", c->nodes);
+    if(found) {
+        fprintf(file, "    \"alpha\": " NUMBER_FORMAT ",\n", c->alpha);
+    } else {
+        fprintf(file, "    \"alpha\": null,\n");
+    }
+    fprintf(file, "    \"stopped\": \"%s\",\n", stops[c->stopped]);
+    if(found || (c->stopped != stop_none)) {
+        fprintf(file, "    \"bound\": " NUMBER_FORMAT ",\n", c->bound);
+    } else {
+        fprintf(file, "    \"bound\": null,\n");
+    }
+    if(isfinite(c->gap)) {
+        fprintf(file, "    \"gap\": %lf,\n", c->gap);
+    } else {
+        fprintf(file, "    \"gap\": null,\n");
+    }
+    fprintf(file, "    \"statistics\": ");
+    stats_json(&c->stats, file, 4);
+    fprintf(file, "\n}\n");
+
+    return ferror(file) == 0;
+}
+
 void imp_model(FILE* report, bip_context* c)
 {
     /* Objective function */
@@ -115,7 +162,7 @@ void imp_model(FILE* report, bip_context* c)
     fprintf(report, "    Z = ");
     for(int i = 0; i < c->num_vars; i++) {
 
-        int coeff = c->function[i];
+        number coeff = c->function[i];
 
         if(coeff == 0) {
             continue;
@@ -126,8 +173,8 @@ void imp_model(FILE* report, bip_context* c)
         } else if(i > 0) {
             fprintf(report, " \\cgreen{+} ");
         }
-        fprintf(report, "%i\\textcolor{%s}{%s_%i}",
-                        abs(coeff),
+        fprintf(report, NUMBER_FORMAT "\\textcolor{%s}{%s_%i}",
+                        (coeff < 0) ? -coeff : coeff,
                         VAR_NAMES[i % VARS],
                         VAR_NAMES[i % VARS],
                         ((i / VARS) + 1)
@@ -146,7 +193,7 @@ void imp_model(FILE* report, bip_context* c)
     for(int i = 0; i < c->num_rest; i++) {
         for(int j = 0; j < c->num_vars; j++) {
 
-            int coeff = c->restrictions->data[i][j];
+            number coeff = rest_coeff(c, i, j);
 
             if(coeff == 0) {
                 fprintf(report, " & & ");
@@ -160,15 +207,15 @@ void imp_model(FILE* report, bip_context* c)
             } else {
                 fprintf(report, " & ");
             }
-            fprintf(report, " %i\\textcolor{%s}{%s_%i}&",
-                            abs(coeff),
+            fprintf(report, " " NUMBER_FORMAT "\\textcolor{%s}{%s_%i}&",
+                            (coeff < 0) ? -coeff : coeff,
                             VAR_NAMES[j % VARS],
                             VAR_NAMES[j % VARS],
                             ((j / VARS) + 1)
                     );
         }
-        int type = c->restrictions->data[i][c->num_vars];
-        int equl = c->restrictions->data[i][c->num_vars + 1];
+        int type = rest_type(c, i);
+        number equl = rest_equl(c, i);
         if(type == LE) {
             fprintf(report, " \\le& ");
         } else if(type == GE) {
@@ -182,7 +229,7 @@ void imp_model(FILE* report, bip_context* c)
         } else {
             fprintf(report, "\\cgreen{+}");
         }
-        fprintf(report, "%i", abs(equl));
+        fprintf(report, NUMBER_FORMAT, (equl < 0) ? -equl : equl);
         if(i < c->num_rest - 1) {
             fprintf(report, " \\\\");
         }
@@ -193,13 +240,14 @@ void imp_model(FILE* report, bip_context* c)
     fprintf(report, "\n");
 }
 
-void imp_node_open(bip_context* c, int* vars, int* parents, int num)
+void imp_node_open(bip_context* c, int* vars, int* parents, int* branched,
+                   int num)
 {
     FILE* report = c->report_buffer;
 
     fprintf(report, "\\subsection{%s %i}\n", "Subproblem", num);
 
-    bool branch = draw_branch(vars, parents, c->num_vars, num);
+    bool branch = draw_branch(vars, parents, branched, c->num_vars, num);
 
     if(branch) {
         fprintf(report, "\\marginpar{%%\n");
@@ -241,13 +289,14 @@ void imp_node_close(bip_context* c, enum CloseReason reason)
     fprintf(report, "\n");
 }
 
-void imp_node_log_bf(bip_context* c, int* fixed, int* vars, int bf, int alpha)
+void imp_node_log_bf(bip_context* c, int* fixed, int* vars, number bf,
+                     number alpha)
 {
     FILE* report = c->report_buffer;
 
     fprintf(report, "%s", "Considering solution: ");
     for(int i = 0; i < c->num_vars; i++) {
-        int coeff = c->function[i];
+        number coeff = c->function[i];
         if(coeff == 0) {
             continue;
         }
@@ -271,32 +320,27 @@ void imp_node_log_bf(bip_context* c, int* fixed, int* vars, int bf, int alpha)
     fprintf(report, "\\begin{align*}\n");
     fprintf(report, "    Z = ");
 
-    int pos = 0;
+    /* Fixed variables first, wherever they are */
     int count = 0;
     for(int i = 0; i < c->num_vars; i++) {
-        int coeff = c->function[i];
+        number coeff = c->function[i];
         int fix = fixed[i];
-        if(fix == -1) {
-            break;
-        }
-        if((coeff == 0) || (fix == 0)) {
-            pos++;
+        if((coeff == 0) || (fix <= 0)) {
             continue;
         }
-        fprintf(report, "%i\\cred{%s_%i}",
+        fprintf(report, NUMBER_FORMAT "\\cred{%s_%i}",
                         coeff, VAR_NAMES[i % VARS], ((i / VARS) + 1)
                 );
-        pos++;
         count++;
     }
 
-    for(int i = pos; i < c->num_vars; i++) {
-        int coeff = c->function[i];
+    for(int i = 0; i < c->num_vars; i++) {
+        number coeff = c->function[i];
         int flt = vars[i];
-        if((coeff == 0) || (flt == 0)) {
+        if((coeff == 0) || (fixed[i] != -1) || (flt == 0)) {
             continue;
         }
-        fprintf(report, "%i\\cgreen{%s_%i}",
+        fprintf(report, NUMBER_FORMAT "\\cgreen{%s_%i}",
                         coeff,
                         VAR_NAMES[i % VARS],
                         ((i / VARS) + 1)
@@ -307,19 +351,19 @@ void imp_node_log_bf(bip_context* c, int* fixed, int* vars, int bf, int alpha)
     if(count > 0) {
         fprintf(report, " =");
     }
-    fprintf(report, " %i", bf);
+    fprintf(report, " " NUMBER_FORMAT, bf);
 
     fprintf(report, "\\end{align*}\n");
     fprintf(report, "\n");
 
     bool free_alpha = true;
-    char* alpha_txt = g_strdup_printf("%i", alpha);
+    char* alpha_txt = g_strdup_printf(NUMBER_FORMAT, alpha);
 
-    if(alpha == INT_MAX) {
+    if(alpha == NUMBER_MAX) {
         g_free(alpha_txt);
         free_alpha = false;
         alpha_txt = "+\\infty";
-    } else if(alpha == INT_MIN) {
+    } else if(alpha == NUMBER_MIN) {
         g_free(alpha_txt);
         free_alpha = false;
         alpha_txt = "-\\infty";
@@ -329,19 +373,25 @@ void imp_node_log_bf(bip_context* c, int* fixed, int* vars, int bf, int alpha)
 
     if(c->maximize) {
         if(bf <= alpha) {
-            fprintf(report, "$%i \\le %s \\longrightarrow$ %s.\n", bf, alpha_txt,
+            fprintf(report, "$" NUMBER_FORMAT
+                            " \\le %s \\longrightarrow$ %s.\n",
+                            bf, alpha_txt,
                             "Doesn't improve performance (maximizing)");
         } else {
-            fprintf(report, "$%i > %s \\longrightarrow$ %s.\n", bf, alpha_txt,
+            fprintf(report, "$" NUMBER_FORMAT " > %s \\longrightarrow$ %s.\n",
+                            bf, alpha_txt,
                             "Improves performance (maximizing)");
         }
 
     } else {
         if(bf >= alpha) {
-            fprintf(report, "$%i \\le %s \\longrightarrow$ %s.\n", bf, alpha_txt,
+            fprintf(report, "$" NUMBER_FORMAT
+                            " \\le %s \\longrightarrow$ %s.\n",
+                            bf, alpha_txt,
                             "Doesn't improve performance (minimizing)");
         } else {
-            fprintf(report, "$%i < %s \\longrightarrow$ %s.\n", bf, alpha_txt,
+            fprintf(report, "$" NUMBER_FORMAT " < %s \\longrightarrow$ %s.\n",
+                            bf, alpha_txt,
                             "Improves performance (minimizing)");
         }
     }
@@ -362,7 +412,7 @@ const char* LINK_TPL = "    %i -> %i "
 "[label = <  <font point-size=\"20\" color=\"%s\">%s</font>"
 "<font point-size=\"9\">%i</font> = %i>];\n";
 
-bool draw_branch(int* vars, int* parents, int bounds, int num)
+bool draw_branch(int* vars, int* parents, int* branched, int bounds, int num)
 {
     /* Create branch file */
     char* path = g_strdup_printf("reports/branch%i.gv", num);
@@ -375,12 +425,9 @@ bool draw_branch(int* vars, int* parents, int bounds, int num)
     /* Preamble */
     fprintf(branch, "%s", GRAPH_HEADER);
 
-    /* Count levels */
+    /* Count levels, the path ends at the current node */
     int levels = 0;
-    for(int i = 0; i < bounds; i++) {
-        if(vars[i] == -1) {
-            break;
-        }
+    while((levels < bounds) && (parents[levels + 1] != -1)) {
         levels++;
     }
 
@@ -403,7 +450,8 @@ bool draw_branch(int* vars, int* parents, int bounds, int num)
     /* Create links */
     for(int i = 0; i < levels; i++) {
 
-        int left = vars[i] == 0;
+        int var = branched[i];
+        int left = vars[var] == 0;
 
         if(!left) {
             fprintf(branch,
@@ -414,10 +462,10 @@ bool draw_branch(int* vars, int* parents, int bounds, int num)
         fprintf(branch, LINK_TPL,
                 parents[i],
                 parents[i + 1],
-                VAR_COLORS[i % VARS],
-                VAR_NAMES[i % VARS],
-                ((i / VARS) + 1),
-                vars[i]
+                VAR_COLORS[var % VARS],
+                VAR_NAMES[var % VARS],
+                ((var / VARS) + 1),
+                vars[var]
             );
 
         if(left) {
@@ -455,29 +503,29 @@ void imp_node_log_ff(bip_context* c)
     fprintf(report, "\\begin{compactitem}\n");
 }
 
-void imp_node_log_calc(bip_context* c, int* rests, int* vars, bool pass, int n)
+void imp_node_log_calc(bip_context* c, int n, int* vars, bool pass)
 {
     FILE* report = c->report_buffer;
     fprintf(report, "\\item $");
 
     /* Prints variables */
     for(int i = 0; i < c->num_vars; i++) {
-        int coeff = rests[i];
+        number coeff = rest_coeff(c, n, i);
 
         if(coeff < 0) {
                 fprintf(report, "\\cred{-}");
         } else if(i > 0) {
             fprintf(report, "\\cgreen{+}");
         }
-        fprintf(report, "%i\\times\\textcolor{%s}{%i}",
-                abs(coeff),
+        fprintf(report, NUMBER_FORMAT "\\times\\textcolor{%s}{%i}",
+                (coeff < 0) ? -coeff : coeff,
                 VAR_NAMES[i % VARS],
                 vars[i]
             );
     }
 
     /* Prints inequality */
-    int type = rests[c->num_vars];
+    int type = rest_type(c, n);
     if(type == LE) {
         if(pass) {
             fprintf(report, " \\le ");
@@ -499,13 +547,13 @@ void imp_node_log_calc(bip_context* c, int* rests, int* vars, bool pass, int n)
     }
 
     /* Prints right part */
-    int equl = rests[c->num_vars + 1];
+    number equl = rest_equl(c, n);
     if(equl < 0) {
             fprintf(report, "\\cred{-}");
     } else {
         fprintf(report, "\\cgreen{+}");
     }
-    fprintf(report, "%i", abs(equl));
+    fprintf(report, NUMBER_FORMAT, (equl < 0) ? -equl : equl);
 
     /* Prints conclusion */
     if(pass) {
@@ -520,3 +568,65 @@ void imp_node_log_calc(bip_context* c, int* rests, int* vars, bool pass, int n)
     }
 }
 
+void imp_node_log_rests(bip_context* c, int* vars)
+{
+    bool pass = true;
+    for(int i = 0; pass && (i < c->num_rest); i++) {
+        pass = check_restriction(c, i, vars);
+        imp_node_log_calc(c, i, vars, pass);
+    }
+}
+
+void imp_node_log_future(bip_context* c, int* fixed, int* workplace)
+{
+    bool pass = true;
+    for(int i = 0; pass && (i < c->num_rest); i++) {
+        pass = check_future_rest(c, i, fixed, workplace);
+        imp_node_log_calc(c, i, workplace, pass);
+    }
+}
+
+void imp_node_log_lp(bip_context* c, bool factible, number bound,
+                     number alpha)
+{
+    FILE* report = c->report_buffer;
+    fprintf(report, "\\noindent\n");
+    fprintf(report, "{\\Large %s:}\n", "LP relaxation");
+    fprintf(report, "\n");
+
+    if(!factible) {
+        fprintf(report, "%s $\\longrightarrow$ %s.\n",
+                        "Relaxation not factible", "No future factibility");
+        fprintf(report, "\n");
+        return;
+    }
+
+    if((alpha == NUMBER_MAX) || (alpha == NUMBER_MIN)) {
+        fprintf(report, "Bound: \\textbf{$" NUMBER_FORMAT "$} "
+                        "$\\longrightarrow$ %s.\n",
+                        bound, "Improves performance");
+    } else if(c->maximize) {
+        if(bound <= alpha) {
+            fprintf(report, "$" NUMBER_FORMAT " \\le " NUMBER_FORMAT
+                            " \\longrightarrow$ %s.\n",
+                            bound, alpha,
+                            "Doesn't improve performance (maximizing)");
+        } else {
+            fprintf(report, "$" NUMBER_FORMAT " > " NUMBER_FORMAT
+                            " \\longrightarrow$ %s.\n",
+                            bound, alpha, "Improves performance (maximizing)");
+        }
+    } else {
+        if(bound >= alpha) {
+            fprintf(report, "$" NUMBER_FORMAT " \\ge " NUMBER_FORMAT
+                            " \\longrightarrow$ %s.\n",
+                            bound, alpha,
+                            "Doesn't improve performance (minimizing)");
+        } else {
+            fprintf(report, "$" NUMBER_FORMAT " < " NUMBER_FORMAT
+                            " \\longrightarrow$ %s.\n",
+                            bound, alpha, "Improves performance (minimizing)");
+        }
+    }
+    fprintf(report, "\n");
+}
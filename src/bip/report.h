@@ -22,13 +22,6 @@
 #include "bip.h"
 #include "graphviz.h"
 
-enum CloseReason {
-    doesnt_improve,
-    new_candidate,
-    not_factible,
-    expand
-};
-
 /**
  * Write a report about the execution of the algorithm.
  *
@@ -38,20 +31,37 @@ enum CloseReason {
  */
 bool implicit_report(bip_context* c);
 
+/**
+ * Write the result and the statistics of the execution of the algorithm as
+ * a JSON object, see stats.h.
+ *
+ * @param bip_context, the binary integer programming context data structure
+ *        after execution.
+ * @param file, where to write them.
+ * @return if the statistics could be written.
+ */
+bool implicit_statistics(bip_context* c, FILE* file);
+
 void imp_model(FILE* report, bip_context* c);
 
-void imp_node_open(bip_context* c, int* vars, int* parents, int num);
+void imp_node_open(bip_context* c, int* vars, int* parents, int* branched,
+                   int num);
 void imp_node_close(bip_context* c, enum CloseReason reason);
 
-void imp_node_log_bf(bip_context* c, int* fixed, int* vars, int bf, int alpha);
+void imp_node_log_bf(bip_context* c, int* fixed, int* vars, number bf,
+                     number alpha);
 void imp_node_log_rc(bip_context* c);
 void imp_node_log_ff(bip_context* c);
-void imp_node_log_calc(bip_context* c, int* rests, int* vars, bool pass, int n);
+void imp_node_log_calc(bip_context* c, int n, int* vars, bool pass);
+void imp_node_log_rests(bip_context* c, int* vars);
+void imp_node_log_future(bip_context* c, int* fixed, int* workplace);
+void imp_node_log_lp(bip_context* c, bool factible, number bound,
+                     number alpha);
 
 // Also:
 // verificación de restricciones, cálculo de factibilidad futura
 
-bool draw_branch(int* vars, int* parents, int bounds, int num);
+bool draw_branch(int* vars, int* parents, int* branched, int bounds, int num);
 
 
 #endif
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stats.h"
+
+/* Names of the reasons and phases in JSON */
+static const char* reason_names[CLOSE_REASONS] = {
+    "doesnt_improve", "new_candidate", "not_factible", "expand"
+};
+static const char* phase_names[SEARCH_PHASES] = {
+    "presolve", "symmetry", "cuts", "heuristics", "search", "report"
+};
+
+void stats_init(search_stats* s)
+{
+    s->incumbents = g_array_new(false, false, sizeof(stats_incumbent));
+    stats_reset(s);
+}
+
+void stats_reset(search_stats* s)
+{
+    s->opened = 0;
+    for(int r = 0; r < CLOSE_REASONS; r++) {
+        s->closed[r] = 0;
+    }
+    s->max_depth = 0;
+    g_array_set_size(s->incumbents, 0);
+    s->peak_memory = 0;
+    for(int p = 0; p < SEARCH_PHASES; p++) {
+        s->phases[p] = 0.0;
+    }
+}
+
+void stats_improved(search_stats* s, double seconds, number alpha)
+{
+    stats_incumbent i = {seconds, alpha};
+    g_array_append_val(s->incumbents, i);
+}
+
+static gint by_time(gconstpointer a, gconstpointer b)
+{
+    double x = ((const stats_incumbent*) a)->seconds;
+    double y = ((const stats_incumbent*) b)->seconds;
+    return (x > y) - (x < y);
+}
+
+void stats_merge(search_stats* s, search_stats* from, number offset,
+                 bool maximize)
+{
+    s->opened += from->opened;
+    for(int r = 0; r < CLOSE_REASONS; r++) {
+        s->closed[r] += from->closed[r];
+    }
+    if(from->max_depth > s->max_depth) {
+        s->max_depth = from->max_depth;
+    }
+    if(from->peak_memory > s->peak_memory) {
+        s->peak_memory = from->peak_memory;
+    }
+    for(int p = 0; p < SEARCH_PHASES; p++) {
+        s->phases[p] += from->phases[p];
+    }
+
+    /* Keep the solutions that improved the earlier ones */
+    GArray* list = s->incumbents;
+    for(guint k = 0; k < from->incumbents->len; k++) {
+        stats_incumbent i = g_array_index(from->incumbents, stats_incumbent,
+                                          k);
+        i.alpha = i.alpha + offset;
+        g_array_append_val(list, i);
+    }
+    g_array_sort(list, by_time);
+
+    guint kept = 0;
+    for(guint k = 0; k < list->len; k++) {
+        stats_incumbent i = g_array_index(list, stats_incumbent, k);
+        if(kept > 0) {
+            number last = g_array_index(list, stats_incumbent, kept - 1).alpha;
+            if((maximize && (i.alpha <= last)) ||
+               (!maximize && (i.alpha >= last))) {
+                continue;
+            }
+        }
+        g_array_index(list, stats_incumbent, kept++) = i;
+    }
+    g_array_set_size(list, kept);
+}
+
+void stats_json(search_stats* s, FILE* file, int indent)
+{
+    int in = indent + 4;
+
+    fprintf(file, "{\n");
+    fprintf(file, "%*s\"opened\": %ld,\n", in, "", s->opened);
+    fprintf(file, "%*s\"closed\": {", in, "");
+    for(int r = 0; r < CLOSE_REASONS; r++) {
+        fprintf(file, "%s\"%s\": %ld", (r == 0) ? "" : ", ",
+                reason_names[r], s->closed[r]);
+    }
+    fprintf(file, "},\n");
+    fprintf(file, "%*s\"max_depth\": %i,\n", in, "", s->max_depth);
+
+    fprintf(file, "%*s\"incumbents\": [", in, "");
+    for(guint k = 0; k < s->incumbents->len; k++) {
+        stats_incumbent i = g_array_index(s->incumbents, stats_incumbent, k);
+        fprintf(file, "%s\n%*s{\"seconds\": %lf, \"alpha\": " NUMBER_FORMAT
+                "}", (k == 0) ? "" : ",", in + 4, "", i.seconds, i.alpha);
+    }
+    if(s->incumbents->len > 0) {
+        fprintf(file, "\n%*s", in, "");
+    }
+    fprintf(file, "],\n");
+
+    fprintf(file, "%*s\"peak_memory\": %lu,\n", in, "", s->peak_memory);
+    fprintf(file, "%*s\"phases\": {", in, "");
+    for(int p = 0; p < SEARCH_PHASES; p++) {
+        fprintf(file, "%s\"%s\": %lf", (p == 0) ? "" : ", ",
+                phase_names[p], s->phases[p]);
+    }
+    fprintf(file, "}\n");
+    fprintf(file, "%*s}", indent, "");
+}
+
+void stats_clear(search_stats* s)
+{
+    if(s->incumbents != NULL) {
+        g_array_free(s->incumbents, true);
+        s->incumbents = NULL;
+    }
+}
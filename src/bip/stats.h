@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_STATS
+#define H_STATS
+
+#include "utils.h"
+#include "matrix.h"
+
+/* Reasons the search gives for closing or expanding a node */
+enum CloseReason {
+    doesnt_improve,
+    new_candidate,
+    not_factible,
+    expand
+};
+
+#define CLOSE_REASONS (expand + 1)
+
+/* Parts of a resolution timed apart */
+enum SearchPhase {
+    phase_presolve,
+    phase_symmetry,
+    phase_cuts,
+    phase_heuristics,
+    phase_search,
+    phase_report,       /* Writing the report, of each node if traced */
+    SEARCH_PHASES
+};
+
+/* Solution that improved the best one found so far */
+typedef struct {
+    double seconds;     /* Since the resolution started */
+    number alpha;
+} stats_incumbent;
+
+/**
+ * Statistics of a resolution.
+ *
+ * Each search counts its nodes in the statistics of its own activity, so
+ * the counters take no lock, and the counts are merged into the context
+ * when the search ends. The search computes the best fit, the restrictions
+ * and their future factibility incrementally as it fixes variables, so
+ * there is no time per node to split among them. Instead, the time is
+ * split among the phases of the resolution.
+ */
+typedef struct {
+
+    long opened;                    /* Nodes evaluated */
+    long closed[CLOSE_REASONS];     /* By the reason of each, expand too */
+    int max_depth;                  /* Most variables fixed at a node */
+    GArray* incumbents;             /* stats_incumbent, oldest first */
+    unsigned long peak_memory;      /* Model and search structures, bytes */
+    double phases[SEARCH_PHASES];   /* Seconds */
+
+} search_stats;
+
+/**
+ * Initialize statistics with everything at 0.
+ *
+ * @param s, the statistics (by reference)
+ * @return nothing
+ */
+void stats_init(search_stats* s);
+
+/**
+ * Set statistics back to 0, to be gathered again.
+ *
+ * @param s, the statistics (by reference)
+ * @return nothing
+ */
+void stats_reset(search_stats* s);
+
+/**
+ * Count a node evaluated by a search.
+ *
+ * @param s, the statistics (by reference)
+ * @param reason, why the node was closed, expand if it wasn't.
+ * @param depth, the number of variables fixed at the node.
+ * @return nothing
+ */
+static inline void stats_node(search_stats* s, enum CloseReason reason,
+                              int depth)
+{
+    s->opened++;
+    s->closed[reason]++;
+    if(depth > s->max_depth) {
+        s->max_depth = depth;
+    }
+}
+
+/**
+ * Keep a solution that improved the best one found so far.
+ *
+ * @param s, the statistics (by reference)
+ * @param seconds, the time since the resolution started.
+ * @param alpha, the performance of the solution.
+ * @return nothing
+ */
+void stats_improved(search_stats* s, double seconds, number alpha);
+
+/**
+ * Add the statistics of a search to the ones of a resolution.
+ *
+ * The solutions are kept in order of time, and only those that improve the
+ * ones found earlier, since searches with their own alpha can find worse
+ * ones.
+ *
+ * @param s, the statistics of the resolution (by reference)
+ * @param from, the statistics of the search (by reference)
+ * @param offset, added to the performances of the solutions, for searches
+ *        of a presolved model.
+ * @param maximize, the direction of the optimization.
+ * @return nothing
+ */
+void stats_merge(search_stats* s, search_stats* from, number offset,
+                 bool maximize);
+
+/**
+ * Write statistics as a JSON object.
+ *
+ * @param s, the statistics (by reference)
+ * @param file, where to write them.
+ * @param indent, the number of spaces before each member.
+ * @return nothing
+ */
+void stats_json(search_stats* s, FILE* file, int indent);
+
+/**
+ * Free the resources associated with statistics.
+ *
+ * @param s, the statistics (by reference)
+ * @return nothing
+ */
+void stats_clear(search_stats* s);
+
+#endif
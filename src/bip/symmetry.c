@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "symmetry.h"
+
+typedef struct {
+    uint64_t hash;
+    int var;
+} hashed;
+
+static int by_hash(const void* x, const void* y)
+{
+    const hashed* p = (const hashed*) x;
+    const hashed* q = (const hashed*) y;
+    if(p->hash != q->hash) {
+        return (p->hash < q->hash) ? -1 : 1;
+    }
+    return p->var - q->var;
+}
+
+static uint64_t mix(uint64_t hash, uint64_t value)
+{
+    hash ^= value;
+    return hash * 1099511628211ULL;
+}
+
+/* Bits of a coefficient, whatever its type */
+static uint64_t bits(number value)
+{
+    uint64_t b = 0;
+    memcpy(&b, &value, sizeof(number));
+    return b;
+}
+
+static uint64_t column_hash(bip_context* c, sparse* s, int j)
+{
+    uint64_t hash = mix(14695981039346656037ULL, bits(c->function[j]));
+    for(int k = s->col_start[j]; k < s->col_start[j + 1]; k++) {
+        hash = mix(hash, (uint64_t) s->col_row[k]);
+        hash = mix(hash, bits(s->col_value[k]));
+    }
+    return hash;
+}
+
+static bool same_column(bip_context* c, sparse* s, int a, int b)
+{
+    int la = s->col_start[a + 1] - s->col_start[a];
+    int lb = s->col_start[b + 1] - s->col_start[b];
+    if((c->function[a] != c->function[b]) || (la != lb)) {
+        return false;
+    }
+    for(int k = 0; k < la; k++) {
+        int ka = s->col_start[a] + k;
+        int kb = s->col_start[b] + k;
+        if((s->col_row[ka] != s->col_row[kb]) ||
+           (s->col_value[ka] != s->col_value[kb])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* The model followed by x[next[j]] <= x[j] for every variable with a next
+ * one in its group */
+static bip_context* ordered(bip_context* c, sparse* s, int* next, int pairs)
+{
+    int n = c->num_vars;
+    int m = c->num_rest;
+    int rests = m + pairs;
+    int nnz = s->nnz + (2 * pairs);
+
+    /* Try to allocate memory */
+    int* starts  = (int*) malloc((rests + 1) * sizeof(int));
+    int* columns = (int*) malloc((nnz + 1) * sizeof(int));
+    number* values = (number*) malloc((nnz + 1) * sizeof(number));
+    int* types     = (int*) malloc((rests + 1) * sizeof(int));
+    number* equls  = (number*) malloc((rests + 1) * sizeof(number));
+    bip_context* r = NULL;
+    if((starts != NULL) && (columns != NULL) && (values != NULL) &&
+       (types != NULL) && (equls != NULL)) {
+
+        memcpy(starts, s->row_start, (m + 1) * sizeof(int));
+        memcpy(columns, s->row_column, s->nnz * sizeof(int));
+        memcpy(values, s->row_value, s->nnz * sizeof(number));
+        for(int i = 0; i < m; i++) {
+            types[i] = rest_type(c, i);
+            equls[i] = rest_equl(c, i);
+        }
+
+        /* The next variable of a group always has a greater index */
+        int i = m;
+        int k = s->nnz;
+        for(int j = 0; j < n; j++) {
+            if(next[j] == -1) {
+                continue;
+            }
+            columns[k] = j;
+            values[k++] = 1;
+            columns[k] = next[j];
+            values[k++] = -1;
+            starts[++i] = k;
+            types[i - 1] = GE;
+            equls[i - 1] = 0;
+        }
+
+        r = bip_context_from_rows(n, rests, starts, columns, values, types,
+                                  equls);
+        if(r != NULL) {
+            r->maximize = c->maximize;
+            memcpy(r->function, c->function, n * sizeof(number));
+        }
+    }
+
+    free(starts);
+    free(columns);
+    free(values);
+    free(types);
+    free(equls);
+    return r;
+}
+
+bip_context* symmetry_break(bip_context* c)
+{
+    int n = c->num_vars;
+
+    /* Walk the restrictions by columns, index the dense ones if needed */
+    sparse* s = c->sparse_rests;
+    if(s == NULL) {
+        if(c->restrictions != NULL) {
+            s = sparse_from_matrix(c->restrictions, n);
+        } else {
+            s = sparse_new(0, n, 0);
+            if(s != NULL) {
+                sparse_index(s);
+            }
+        }
+        if(s == NULL) {
+            return NULL;
+        }
+    }
+
+    /* Try to allocate memory */
+    hashed* order = (hashed*) malloc((n + 1) * sizeof(hashed));
+    int* next = (int*) malloc((n + 1) * sizeof(int));
+    int* last = (int*) malloc((n + 1) * sizeof(int));
+    bip_context* r = NULL;
+    if((order != NULL) && (next != NULL) && (last != NULL)) {
+
+        for(int j = 0; j < n; j++) {
+            order[j].hash = column_hash(c, s, j);
+            order[j].var = j;
+            next[j] = -1;
+        }
+        qsort(order, n, sizeof(hashed), by_hash);
+
+        /* Split each run of equal hashes into groups of identical columns,
+         * 'last' holds the last variable of each group of the run. Within a
+         * run variables come by increasing index. */
+        int pairs = 0;
+        for(int a = 0; a < n; ) {
+            int b = a;
+            while((b < n) && (order[b].hash == order[a].hash)) {
+                b++;
+            }
+            int found = 0;
+            for(int k = a; k < b; k++) {
+                int j = order[k].var;
+                int g = 0;
+                while((g < found) && !same_column(c, s, last[g], j)) {
+                    g++;
+                }
+                if(g == found) {
+                    found++;
+                } else {
+                    next[last[g]] = j;
+                    pairs++;
+                }
+                last[g] = j;
+            }
+            a = b;
+        }
+
+        DEBUG("Symmetry: %i ordering restrictions.\n", pairs);
+        if(pairs > 0) {
+            r = ordered(c, s, next, pairs);
+        }
+    }
+
+    if(s != c->sparse_rests) {
+        sparse_free(s);
+    }
+    free(order);
+    free(next);
+    free(last);
+    return r;
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef H_SYMMETRY
+#define H_SYMMETRY
+
+#include "bip.h"
+
+/**
+ * Break the symmetry of interchangeable variables.
+ *
+ * Variables with the same objective coefficient and the same coefficients
+ * in every restriction can swap values in any solution without changing its
+ * performance or its factibility, so the search would explore every
+ * permutation of them. Such columns are grouped comparing a hash of each
+ * one first, and each group x1, x2, ..., xk is ordered with the restrictions
+ * x1 - x2 >= 0, ..., x(k-1) - xk >= 0. Sorting the values of a group turns
+ * any solution into one that satisfies them, so an optimal solution is
+ * always left. With identical columns this is the lexicographic ordering
+ * of the columns, and propagation of the new restrictions does the orbital
+ * fixing: a variable fixed to 1 fixes the ones before it to 1, fixed to 0
+ * the ones after it to 0.
+ *
+ * @param c, the binary integer programming context data structure.
+ * @return a new context with the same variables and objective, and the
+ *         restrictions of the model followed by the ordering ones, or NULL
+ *         if no variables are interchangeable or enough memory could not be
+ *         allocated. Options are left to the caller.
+ */
+bip_context* symmetry_break(bip_context* c);
+
+#endif
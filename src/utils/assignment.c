@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "assignment.h"
+
+assignment* assignment_new(int size)
+{
+    if(size < 0) {
+        return NULL;
+    }
+
+    /* Allocate structure */
+    assignment* a = (assignment*) malloc(sizeof(assignment));
+    if(a == NULL) {
+        return NULL;
+    }
+
+    a->size = size;
+    a->words = ASSIGNMENT_WORDS(size);
+
+    /* Mask and value share a single block */
+    a->mask = (uint64_t*) malloc((2 * a->words + 1) * sizeof(uint64_t));
+    if(a->mask == NULL) {
+        free(a);
+        return NULL;
+    }
+    a->value = a->mask + a->words;
+
+    assignment_clear(a);
+    return a;
+}
+
+void assignment_clear(assignment* a)
+{
+    memset(a->mask, 0, 2 * a->words * sizeof(uint64_t));
+}
+
+void assignment_copy(assignment* src, assignment* dest)
+{
+    memcpy(dest->mask, src->mask, 2 * src->words * sizeof(uint64_t));
+}
+
+void assignment_to_vector(assignment* a, int* vars)
+{
+    for(int j = 0; j < a->size; j++) {
+        vars[j] = assignment_get(a, j);
+    }
+}
+
+number assignment_dot(assignment* a, number* coeffs)
+{
+    number dp = 0;
+    for(int w = 0; w < a->words; w++) {
+        uint64_t bits = a->value[w];
+        while(bits != 0) {
+            int j = (w * ASSIGNMENT_BITS) + __builtin_ctzll(bits);
+            dp += coeffs[j];
+            bits &= bits - 1;
+        }
+    }
+    return dp;
+}
+
+int assignment_count(assignment* a)
+{
+    int count = 0;
+    for(int w = 0; w < a->words; w++) {
+        count += __builtin_popcountll(a->mask[w]);
+    }
+    return count;
+}
+
+int assignment_first_free(assignment* a)
+{
+    for(int w = 0; w < a->words; w++) {
+        uint64_t unset = ~a->mask[w];
+        if(unset != 0) {
+            int j = (w * ASSIGNMENT_BITS) + __builtin_ctzll(unset);
+            return (j < a->size) ? j : -1;
+        }
+    }
+    return -1;
+}
+
+unsigned int assignment_sizeof(assignment* a)
+{
+    if(a == NULL) {
+        return 0;
+    }
+    return sizeof(assignment) + ((2 * a->words + 1) * sizeof(uint64_t));
+}
+
+void assignment_free(assignment* a)
+{
+    if(a == NULL) {
+        return;
+    }
+    free(a->mask);
+    free(a);
+}
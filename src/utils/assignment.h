@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_ASSIGNMENT
+#define H_ASSIGNMENT
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "matrix.h"
+
+#define ASSIGNMENT_BITS 64
+#define ASSIGNMENT_WORDS(size) \
+    (((size) + ASSIGNMENT_BITS - 1) / ASSIGNMENT_BITS)
+
+/**
+ * Bit-packed assignment of binary variables.
+ *
+ * Bit j of 'mask' is set if variable j is fixed, and bit j of 'value' holds
+ * its value. Bits of 'value' outside 'mask' are always zero. Both arrays have
+ * 'words' words, so an assignment of n variables takes n / 4 bytes instead
+ * of the 4n bytes of an int vector.
+ */
+typedef struct {
+    int size;
+    int words;
+    uint64_t* mask;
+    uint64_t* value;
+} assignment;
+
+/**
+ * Create an assignment with all variables free.
+ *
+ * @param size, the number of variables.
+ * @return a pointer to the assignment structure or NULL if enough memory
+ *         could not be allocated.
+ */
+assignment* assignment_new(int size);
+
+/**
+ * Free all variables.
+ *
+ * @param a, an assignment structure (by reference)
+ * @return nothing
+ */
+void assignment_clear(assignment* a);
+
+/**
+ * Copy an assignment into another of the same size.
+ *
+ * @param src, the source assignment structure (by reference)
+ *        dest, the destination assignment structure (by reference)
+ * @return nothing
+ */
+void assignment_copy(assignment* src, assignment* dest);
+
+/**
+ * Unpack an assignment to a vector, with -1 for the free variables.
+ *
+ * @param a, an assignment structure (by reference)
+ * @param vars, the destination vector of 'size' elements.
+ * @return nothing
+ */
+void assignment_to_vector(assignment* a, int* vars);
+
+/**
+ * Calculate the scalar product of the fixed values with a coefficient vector,
+ * gathering only the coefficients of the variables fixed to 1.
+ *
+ * @param a, an assignment structure (by reference)
+ * @param coeffs, the coefficients of each variable.
+ * @return the scalar product.
+ */
+number assignment_dot(assignment* a, number* coeffs);
+
+/**
+ * Count the fixed variables.
+ *
+ * @param a, an assignment structure (by reference)
+ * @return the number of fixed variables.
+ */
+int assignment_count(assignment* a);
+
+/**
+ * Find the first free variable, a word at a time.
+ *
+ * @param a, an assignment structure (by reference)
+ * @return the index of the first free variable or -1 if all are fixed.
+ */
+int assignment_first_free(assignment* a);
+
+/**
+ * Calculates the memory required by the assignment.
+ *
+ * @return the size of the assignment in bytes.
+ * @param a, an assignment structure (by reference)
+ */
+unsigned int assignment_sizeof(assignment* a);
+
+/**
+ * Free resources associated with an assignment.
+ *
+ * @return nothing
+ * @param a, an assignment structure (by reference)
+ */
+void assignment_free(assignment* a);
+
+/* Single variable access, inlined as the search uses them on every node */
+static inline int assignment_get(assignment* a, int var)
+{
+    uint64_t bit = (uint64_t) 1 << (var % ASSIGNMENT_BITS);
+    int w = var / ASSIGNMENT_BITS;
+    if(!(a->mask[w] & bit)) {
+        return -1;
+    }
+    return (a->value[w] & bit) ? 1 : 0;
+}
+
+static inline void assignment_set(assignment* a, int var, int value)
+{
+    uint64_t bit = (uint64_t) 1 << (var % ASSIGNMENT_BITS);
+    int w = var / ASSIGNMENT_BITS;
+    a->mask[w] |= bit;
+    if(value) {
+        a->value[w] |= bit;
+    } else {
+        a->value[w] &= ~bit;
+    }
+}
+
+static inline void assignment_unset(assignment* a, int var)
+{
+    uint64_t bit = (uint64_t) 1 << (var % ASSIGNMENT_BITS);
+    int w = var / ASSIGNMENT_BITS;
+    a->mask[w] &= ~bit;
+    a->value[w] &= ~bit;
+}
+
+#endif
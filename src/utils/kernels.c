@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kernels.h"
+#include <stddef.h>
+#include <glib.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define KERNELS_X86 1
+#include <immintrin.h>
+#else
+#define KERNELS_X86 0
+#endif
+
+/**************
+ * SCALAR
+ **************/
+static void axpy_scalar(double* y, double a, const double* x, int size)
+{
+    for(int i = 0; i < size; i++) {
+        y[i] += a * x[i];
+    }
+}
+
+#if KERNELS_X86
+
+/**************
+ * SSE2
+ **************/
+__attribute__((target("sse2")))
+static void axpy_sse(double* y, double a, const double* x, int size)
+{
+    __m128d va = _mm_set1_pd(a);
+    int i = 0;
+    for(; i + 2 <= size; i += 2) {
+        __m128d vx = _mm_loadu_pd(x + i);
+        __m128d vy = _mm_loadu_pd(y + i);
+        _mm_storeu_pd(y + i, _mm_add_pd(vy, _mm_mul_pd(va, vx)));
+    }
+    axpy_scalar(y + i, a, x + i, size - i);
+}
+
+/**************
+ * AVX
+ **************/
+__attribute__((target("avx")))
+static void axpy_avx(double* y, double a, const double* x, int size)
+{
+    __m256d va = _mm256_set1_pd(a);
+    int i = 0;
+    for(; i + 8 <= size; i += 8) {
+        __m256d x0 = _mm256_loadu_pd(x + i);
+        __m256d x1 = _mm256_loadu_pd(x + i + 4);
+        __m256d y0 = _mm256_loadu_pd(y + i);
+        __m256d y1 = _mm256_loadu_pd(y + i + 4);
+        _mm256_storeu_pd(y + i, _mm256_add_pd(y0, _mm256_mul_pd(va, x0)));
+        _mm256_storeu_pd(y + i + 4,
+                         _mm256_add_pd(y1, _mm256_mul_pd(va, x1)));
+    }
+    for(; i + 4 <= size; i += 4) {
+        __m256d vx = _mm256_loadu_pd(x + i);
+        __m256d vy = _mm256_loadu_pd(y + i);
+        _mm256_storeu_pd(y + i, _mm256_add_pd(vy, _mm256_mul_pd(va, vx)));
+    }
+    axpy_scalar(y + i, a, x + i, size - i);
+}
+
+#endif
+
+/**************
+ * DISPATCH
+ **************/
+typedef struct {
+    const char* name;
+    void (*axpy)(double*, double, const double*, int);
+} kernel_set;
+
+static const kernel_set SCALAR = {
+    "scalar", axpy_scalar
+};
+
+#if KERNELS_X86
+static const kernel_set SSE = {
+    "sse2", axpy_sse
+};
+static const kernel_set AVX = {
+    "avx", axpy_avx
+};
+#endif
+
+static GOnce selection = G_ONCE_INIT;
+
+static gpointer detect_kernels(gpointer data)
+{
+    const kernel_set* selected = &SCALAR;
+#if KERNELS_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx")) {
+        selected = &AVX;
+    } else if(__builtin_cpu_supports("sse2")) {
+        selected = &SSE;
+    }
+#endif
+    return (gpointer) selected;
+}
+
+static const kernel_set* select_kernels(void)
+{
+    /* The workers of a parallel search can call the kernels at once */
+    return (const kernel_set*) g_once(&selection, detect_kernels, NULL);
+}
+
+void kernel_axpy(double* y, double a, const double* x, int size)
+{
+    select_kernels()->axpy(y, a, x, size);
+}
+
+const char* kernel_name(void)
+{
+    return select_kernels()->name;
+}
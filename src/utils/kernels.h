@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_KERNELS
+#define H_KERNELS
+
+/**
+ * Vector kernels of the LP relaxation.
+ *
+ * Each kernel has a scalar, an SSE2 and an AVX version. The best one the CPU
+ * supports is selected the first time any kernel is called. Vector versions
+ * are only built with GCC compatible compilers on x86. They multiply and add
+ * separately, as the scalar one, so every version gives the same results
+ * to the last bit and the search doesn't depend on the CPU.
+ */
+
+/**
+ * Add a multiple of a vector to another one: y = y + a * x.
+ *
+ * @param y, the vector updated.
+ * @param a, the multiple.
+ * @param x, the vector added, not overlapping y.
+ * @param size, the number of elements of the vectors.
+ * @return nothing
+ */
+void kernel_axpy(double* y, double a, const double* x, int size);
+
+/**
+ * Name of the kernels in use: "avx", "sse2" or "scalar".
+ */
+const char* kernel_name(void);
+
+#endif
@@ -27,11 +27,8 @@ bool matrix_copy(matrix* src, matrix* dest)
         return false;
     }
 
-    for(int i = 0; i < src->rows; i++) {
-        for(int j = 0; j < src->columns; j++) {
-            dest->data[i][j] = src->data[i][j];
-        }
-    }
+    memcpy(dest->cells, src->cells,
+           src->rows * src->stride * sizeof(MATRIX_DATATYPE));
     return true;
 }
 
@@ -41,9 +38,16 @@ void matrix_fill(matrix* m, MATRIX_DATATYPE value)
         return;
     }
 
+    if(value == 0) {
+        memset(m->cells, 0, m->rows * m->stride * sizeof(MATRIX_DATATYPE));
+        return;
+    }
+
+    /* Padding is left untouched */
     for(int i = 0; i < m->rows; i++) {
+        MATRIX_DATATYPE* row = m->data[i];
         for(int j = 0; j < m->columns; j++) {
-            m->data[i][j] = value;
+            row[j] = value;
         }
     }
 }
@@ -53,15 +57,13 @@ void matrix_print(matrix* m)
     printf("Table: %i x %i\n", m->rows, m->columns);
     for(int i = 0; i < m->rows; i++) {
         for(int j = 0; j < m->columns; j++) {
-            int cell = m->data[i][j];
-            /* float cell = m->data[i][j]; */
-            if(cell == INT_MAX) {
+            number cell = m->data[i][j];
+            if(cell == NUMBER_MAX) {
                 printf("+oo ");
-            } else if(cell == INT_MIN) {
+            } else if(cell == NUMBER_MIN) {
                 printf("-oo ");
             } else {
-                printf("%i ", cell);
-                /* printf("%4.2f ", cell); */
+                printf(NUMBER_FORMAT " ", cell);
             }
         }
         printf("\n");
@@ -81,12 +83,18 @@ matrix* matrix_new(int rows, int columns, MATRIX_DATATYPE fill)
         return NULL;
     }
 
+    /* Pad rows to a whole number of cache lines */
+    int per_line = MATRIX_ALIGN / sizeof(MATRIX_DATATYPE);
+    int stride = ((columns + per_line - 1) / per_line) * per_line;
+
     m->rows = rows;
     m->columns = columns;
-    m->data = NULL;
+    m->stride = stride;
 
-    /* Create the rows array with unknown columns pointers */
-    m->data = (MATRIX_DATATYPE**) malloc(rows * sizeof(MATRIX_DATATYPE*));
+    /* Allocate the rows array and the cells in a single block */
+    size_t index = rows * sizeof(MATRIX_DATATYPE*);
+    size_t cells = (size_t) rows * stride * sizeof(MATRIX_DATATYPE);
+    m->data = (MATRIX_DATATYPE**) malloc(index + MATRIX_ALIGN + cells);
 
     /* Check if allocation could be done */
     if(m->data == NULL) {
@@ -94,28 +102,16 @@ matrix* matrix_new(int rows, int columns, MATRIX_DATATYPE fill)
         return NULL;
     }
 
-    /* Create the columns arrays and put their pointers on the rows array */
+    /* Align the cells after the rows array and point the rows to them */
+    uintptr_t start = (uintptr_t) m->data + index;
+    start = (start + MATRIX_ALIGN - 1) & ~((uintptr_t) MATRIX_ALIGN - 1);
+    m->cells = (MATRIX_DATATYPE*) start;
     for(int i = 0; i < rows; i++) {
-
-        m->data[i] = (MATRIX_DATATYPE*) malloc(columns * sizeof(MATRIX_DATATYPE));
-
-        /* Check if allocation could be done */
-        if(m->data[i] == NULL) {
-
-            /* Allocation failed, rollback and free memory */
-            for(int j = (i - 1); j >= 0; j--) {
-                free(m->data[j]);
-            }
-
-            /* Free the rows array */
-            free(m->data);
-
-            free(m);
-            return NULL;
-        }
+        m->data[i] = m->cells + (i * stride);
     }
 
-    /* Initialize the matrix */
+    /* Initialize the matrix, padding included */
+    memset(m->cells, 0, cells);
     matrix_fill(m, fill);
 
     return m;
@@ -126,28 +122,21 @@ unsigned int matrix_sizeof(matrix* m)
     if(m == NULL) {
         return 0;
     }
-    int s = (m->rows * sizeof(MATRIX_DATATYPE*)) +
-            (m->rows * (m->columns * sizeof(MATRIX_DATATYPE)));
+    int s = sizeof(matrix) +
+            (m->rows * sizeof(MATRIX_DATATYPE*)) + MATRIX_ALIGN +
+            (m->rows * (m->stride * sizeof(MATRIX_DATATYPE)));
     return s;
 }
 
 void matrix_free(matrix* m)
 {
-    /* Check if matrix has somethign */
-    if((m != NULL) && (m->data != NULL)) {
-
-        /* Release the columns arrays */
-        for(int i = 0; i < m->rows; i++) {
-            if(m->data[i] !=  NULL) {
-                free(m->data[i]);
-            } else {
-                printf("Warning! Row %i was NULL!!", i);
-            }
-        }
+    /* Check if matrix has something */
+    if(m != NULL) {
 
-        /* Release the rows array */
+        /* Release the rows array and the cells */
         free(m->data);
         m->data = NULL;
+        m->cells = NULL;
         free(m);
     }
 
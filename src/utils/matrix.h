@@ -22,14 +22,93 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
-/* #include <float.h> */
+#include <float.h>
 #include <limits.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <math.h>
 
-#define MATRIX_DATATYPE int
+/**
+ * Type of the coefficients of the models and of their sums, selected at
+ * build time: int by default, 64 bits integers if COEFF_INT64 is defined or
+ * doubles if COEFF_DOUBLE is. NUMBER_MIN and NUMBER_MAX are left apart as
+ * sentinels, and NUMBER_LIMIT is the largest sum that is kept exactly (a
+ * double only holds integers exactly up to 2^53).
+ */
+#if defined(COEFF_INT64)
+typedef int64_t number;
+#define NUMBER_MIN INT64_MIN
+#define NUMBER_MAX INT64_MAX
+#define NUMBER_LIMIT INT64_MAX
+#define NUMBER_FORMAT "%" PRId64
+#define NUMBER_SCAN "%" SCNd64
+#define NUMBER_INT 0
+#elif defined(COEFF_DOUBLE)
+typedef double number;
+#define NUMBER_MIN (-DBL_MAX)
+#define NUMBER_MAX DBL_MAX
+#define NUMBER_LIMIT 9007199254740992.0
+#define NUMBER_FORMAT "%.15g"
+#define NUMBER_SCAN "%lf"
+#define NUMBER_INT 0
+#else
+typedef int number;
+#define NUMBER_MIN INT_MIN
+#define NUMBER_MAX INT_MAX
+#define NUMBER_LIMIT INT_MAX
+#define NUMBER_FORMAT "%i"
+#define NUMBER_SCAN "%i"
+#define NUMBER_INT 1
+#endif
+
+#define MATRIX_DATATYPE number
 
+/**
+ * Checked addition and subtraction.
+ *
+ * @param a, b, the operands.
+ * @param result, where to store a + b or a - b.
+ * @return FALSE if the result is beyond NUMBER_LIMIT, in which case it is
+ *         not to be used.
+ */
+static inline bool number_add(number a, number b, number* result)
+{
+#if defined(COEFF_DOUBLE)
+    *result = a + b;
+    return fabs(*result) <= NUMBER_LIMIT;
+#else
+    return !__builtin_add_overflow(a, b, result);
+#endif
+}
+
+static inline bool number_sub(number a, number b, number* result)
+{
+#if defined(COEFF_DOUBLE)
+    *result = a - b;
+    return fabs(*result) <= NUMBER_LIMIT;
+#else
+    return !__builtin_sub_overflow(a, b, result);
+#endif
+}
+
+/* Rows start on cache line boundaries */
+#define MATRIX_ALIGN 64
+
+/**
+ * Matrix data structure.
+ *
+ * Cells are stored row-major in a single contiguous buffer, aligned to
+ * MATRIX_ALIGN bytes, where each row takes 'stride' cells (columns plus
+ * padding up to the next cache line). Padding cells are always zero. 'data'
+ * is an array of pointers to the start of each row, so cells are still
+ * accessed as data[row][column].
+ */
 typedef struct {
         int rows;
         int columns;
+        int stride;
+        MATRIX_DATATYPE *cells;
         MATRIX_DATATYPE **data;
 } matrix;
 
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sparse.h"
+
+sparse* sparse_new(int rows, int columns, int nnz)
+{
+    /* Check if the matrix has a correct size */
+    if(rows < 0 || columns < 1 || nnz < 0) {
+        return NULL;
+    }
+
+    /* Allocate structure */
+    sparse* s = (sparse*) malloc(sizeof(sparse));
+    if(s == NULL) {
+        return NULL;
+    }
+
+    s->rows = rows;
+    s->columns = columns;
+    s->nnz = nnz;
+
+    /* Try to allocate dynamic memory, one extra cell so nnz may be 0 */
+    s->row_start  = (int*) malloc((rows + 1) * sizeof(int));
+    s->row_column = (int*) malloc((nnz + 1) * sizeof(int));
+    s->row_value  = (MATRIX_DATATYPE*)
+                        malloc((nnz + 1) * sizeof(MATRIX_DATATYPE));
+    s->col_start  = (int*) malloc((columns + 1) * sizeof(int));
+    s->col_row    = (int*) malloc((nnz + 1) * sizeof(int));
+    s->col_value  = (MATRIX_DATATYPE*)
+                        malloc((nnz + 1) * sizeof(MATRIX_DATATYPE));
+    if((s->row_start == NULL) || (s->row_column == NULL) ||
+       (s->row_value == NULL) || (s->col_start == NULL) ||
+       (s->col_row == NULL) || (s->col_value == NULL)) {
+        sparse_free(s);
+        return NULL;
+    }
+
+    s->row_start[0] = 0;
+    s->row_start[rows] = nnz;
+
+    return s;
+}
+
+void sparse_index(sparse* s)
+{
+    /* Count nonzeros per column */
+    for(int j = 0; j <= s->columns; j++) {
+        s->col_start[j] = 0;
+    }
+    for(int k = 0; k < s->nnz; k++) {
+        s->col_start[s->row_column[k] + 1]++;
+    }
+    for(int j = 0; j < s->columns; j++) {
+        s->col_start[j + 1] += s->col_start[j];
+    }
+
+    /* Scatter by rows, so each column ends sorted by row */
+    for(int i = 0; i < s->rows; i++) {
+        for(int k = s->row_start[i]; k < s->row_start[i + 1]; k++) {
+            int j = s->row_column[k];
+            int pos = s->col_start[j]++;
+            s->col_row[pos] = i;
+            s->col_value[pos] = s->row_value[k];
+        }
+    }
+
+    /* Scattering moved every start to the next column, restore them */
+    for(int j = s->columns; j > 0; j--) {
+        s->col_start[j] = s->col_start[j - 1];
+    }
+    s->col_start[0] = 0;
+}
+
+int matrix_nnz(matrix* m, int columns)
+{
+    if(m == NULL) {
+        return 0;
+    }
+
+    int nnz = 0;
+    for(int i = 0; i < m->rows; i++) {
+        MATRIX_DATATYPE* row = m->data[i];
+        for(int j = 0; j < columns; j++) {
+            if(row[j] != 0) {
+                nnz++;
+            }
+        }
+    }
+    return nnz;
+}
+
+sparse* sparse_from_matrix(matrix* m, int columns)
+{
+    if(m == NULL) {
+        return NULL;
+    }
+
+    sparse* s = sparse_new(m->rows, columns, matrix_nnz(m, columns));
+    if(s == NULL) {
+        return NULL;
+    }
+
+    int k = 0;
+    for(int i = 0; i < m->rows; i++) {
+        MATRIX_DATATYPE* row = m->data[i];
+        s->row_start[i] = k;
+        for(int j = 0; j < columns; j++) {
+            if(row[j] != 0) {
+                s->row_column[k] = j;
+                s->row_value[k] = row[j];
+                k++;
+            }
+        }
+    }
+    sparse_index(s);
+
+    return s;
+}
+
+MATRIX_DATATYPE sparse_get(sparse* s, int row, int column)
+{
+    /* Binary search on the sorted row */
+    int lo = s->row_start[row];
+    int hi = s->row_start[row + 1] - 1;
+    while(lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int j = s->row_column[mid];
+        if(j == column) {
+            return s->row_value[mid];
+        }
+        if(j < column) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return 0;
+}
+
+unsigned int sparse_sizeof(sparse* s)
+{
+    if(s == NULL) {
+        return 0;
+    }
+    int size = sizeof(sparse) +
+               ((s->rows + 1) * sizeof(int)) +
+               ((s->columns + 1) * sizeof(int)) +
+               (2 * (s->nnz + 1) * (sizeof(int) + sizeof(MATRIX_DATATYPE)));
+    return size;
+}
+
+void sparse_free(sparse* s)
+{
+    if(s == NULL) {
+        return;
+    }
+    free(s->row_start);
+    free(s->row_column);
+    free(s->row_value);
+    free(s->col_start);
+    free(s->col_row);
+    free(s->col_value);
+    free(s);
+}
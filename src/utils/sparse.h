@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2012 Carolina Aguilar <caroagse@gmail.com>
+ * Copyright (C) 2012 Carlos Jenkins <carlos@jenkins.co.cr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef H_SPARSE
+#define H_SPARSE
+
+#include "matrix.h"
+
+/**
+ * Sparse matrix data structure.
+ *
+ * Only nonzero cells are stored, indexed both by row (CSR) and by column
+ * (CSC). The nonzeros of row i are row_column[k], row_value[k] for
+ * row_start[i] <= k < row_start[i + 1], sorted by column. The nonzeros of
+ * column j are col_row[k], col_value[k] for col_start[j] <= k <
+ * col_start[j + 1], sorted by row.
+ */
+typedef struct {
+        int rows;
+        int columns;
+        int nnz;
+
+        /* Row-major */
+        int* row_start;
+        int* row_column;
+        MATRIX_DATATYPE* row_value;
+
+        /* Column-major */
+        int* col_start;
+        int* col_row;
+        MATRIX_DATATYPE* col_value;
+} sparse;
+
+/**
+ * Create an empty sparse matrix with room for the given nonzeros.
+ *
+ * The row-major arrays must be filled by the caller, then sparse_index()
+ * builds the column-major ones.
+ *
+ * @param rows, the number of rows
+ * @param columns, the number of columns
+ * @param nnz, the number of nonzero cells.
+ * @return a pointer to the sparse structure or NULL if enough memory could
+ *         not be allocated.
+ */
+sparse* sparse_new(int rows, int columns, int nnz);
+
+/**
+ * Build the column-major index from the row-major arrays.
+ *
+ * @param s, a sparse structure (by reference)
+ * @return nothing
+ */
+void sparse_index(sparse* s);
+
+/**
+ * Create a sparse matrix from the first columns of a dense one.
+ *
+ * @param m, a matrix structure (by reference)
+ * @param columns, the number of columns to take.
+ * @return a pointer to the sparse structure or NULL if enough memory could
+ *         not be allocated.
+ */
+sparse* sparse_from_matrix(matrix* m, int columns);
+
+/**
+ * Count the nonzero cells in the first columns of a dense matrix.
+ *
+ * @param m, a matrix structure (by reference)
+ * @param columns, the number of columns to take.
+ * @return the number of nonzero cells.
+ */
+int matrix_nnz(matrix* m, int columns);
+
+/**
+ * Get the value of a cell.
+ *
+ * @param s, a sparse structure (by reference)
+ * @param row, the row of the cell.
+ * @param column, the column of the cell.
+ * @return the value of the cell, 0 if it isn't stored.
+ */
+MATRIX_DATATYPE sparse_get(sparse* s, int row, int column);
+
+/**
+ * Calculates the memory required by the sparse matrix.
+ *
+ * @return the size of the sparse matrix in bytes.
+ * @param s, a sparse structure (by reference)
+ */
+unsigned int sparse_sizeof(sparse* s);
+
+/**
+ * Free resources associated with a sparse matrix.
+ *
+ * @return nothing
+ * @param s, a sparse structure (by reference)
+ */
+void sparse_free(sparse* s);
+
+#endif
@@ -19,7 +19,9 @@
 #ifndef H_UTILS
 #define H_UTILS
 
-#define DEBUG_PRINT_ENABLED 1  // uncomment to enable DEBUG statements
+#ifndef DEBUG_PRINT_ENABLED
+#define DEBUG_PRINT_ENABLED 1  // build with 0 to disable DEBUG statements
+#endif
 #if DEBUG_PRINT_ENABLED
 #define DEBUG printf
 #else